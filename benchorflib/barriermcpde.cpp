@@ -0,0 +1,110 @@
+/**
+@file  barriermcpde.cpp
+@brief Check of the Monte Carlo prices of discretely monitored barrier options against the PDE prices
+*/
+
+#include <benchorflib/benchorflib.hpp>
+#include <orflib/market/yieldcurve.hpp>
+#include <orflib/market/volatilitytermstructure.hpp>
+#include <orflib/products/barriercallput.hpp>
+#include <orflib/methods/pde/pde1dsolver.hpp>
+#include <orflib/pricers/bsmcpricer.hpp>
+#include <orflib/math/stats/meanvarcalculator.hpp>
+
+#include <cmath>
+#include <cstdio>
+
+BEGIN_NAMESPACE(orf)
+
+namespace
+{
+  // market data
+  double const spot = 100.0, divyld = 0.02, vol = 0.2, rate = 0.05, maturity = 1.0;
+
+  struct Case
+  {
+    char const* name;
+    int payoffType;
+    double strike, barrier;
+    char const* barrierType;
+    BarrierCallPut::Freq frequency;
+    double simDatesTol;   // relative tolerance of the price on the coarse simulation dates
+  };
+
+  double mcPrice(SPtrProduct prod, SPtrYieldCurve spyc, unsigned long npaths, double& stderror)
+  {
+    BsMcPricer pricer(prod, spyc, divyld, vol, spot, McParams());
+    MeanVarCalculator<double*> sc(pricer.nVariables());
+    pricer.simulate(sc, npaths);
+    Matrix const& results = sc.results();
+    stderror = std::sqrt(results(1, 0) / sc.nSamples());
+    return results(0, 0);
+  }
+
+  double pdePrice(SPtrProduct prod, SPtrYieldCurve spyc, SPtrVolatilityTermStructure spvol)
+  {
+    PdeParams params;
+    params.nTimeSteps = 2000;
+    params.nSpotNodes[0] = 2000;
+    params.nStdDevs[0] = 6.0;
+    params.scheme = PdeParams::Scheme::RANNACHER;
+    Pde1DResults results;
+    Pde1DSolver solver(prod, spyc, spot, divyld, spvol, results);
+    solver.solve(params);
+    return results.prices[0];
+  }
+}
+
+int benchBarrierMcPde(std::vector<std::string> const& args)
+{
+  unsigned long npaths = args.size() > 0 ? std::stoul(args[0]) : 100000;
+  size_t nSimDates = args.size() > 1 ? std::stoul(args[1]) : 12;
+
+  double maturities[] = { maturity };
+  double zerorates[] = { rate };
+  double vols[] = { vol };
+  SPtrYieldCurve spyc(new YieldCurve(maturities, maturities + 1, zerorates, zerorates + 1));
+  SPtrVolatilityTermStructure spvol(new VolatilityTermStructure(maturities, maturities + 1, vols, vols + 1));
+
+  Case const cases[] = {
+    { "uo call daily", 1, 100.0, 130.0, "uo", BarrierCallPut::Freq::DAILY, 0.015 },
+    { "uo call weekly", 1, 100.0, 130.0, "uo", BarrierCallPut::Freq::WEEKLY, 0.03 },
+    { "do put monthly", -1, 100.0, 85.0, "do", BarrierCallPut::Freq::MONTHLY, 0.1 }
+  };
+
+  // the Monte Carlo on the monitoring dates is unbiased; on the coarse simulation dates the
+  // Broadie-Glasserman-Kou shift leaves a bias that grows with the monitoring interval,
+  // allowed for by the relative tolerance of each case
+  double const nStdErrors = 4.0;
+  int failed = 0;
+  std::printf("npaths = %lu, nSimDates = %zu\n", npaths, nSimDates);
+  std::printf("%-16s %10s %10s %9s %10s %9s %s\n",
+              "product", "pde", "mc fix", "stderror", "mc sim", "stderror", "check");
+  for (Case const& c : cases) {
+    SPtrProduct fixProd(new BarrierCallPut(c.payoffType, c.strike, c.barrier, c.barrierType, c.frequency, maturity));
+    SPtrProduct simProd(new BarrierCallPut(c.payoffType, c.strike, c.barrier, c.barrierType, c.frequency, maturity,
+                                           nSimDates));
+    double pde = pdePrice(fixProd, spyc, spvol);
+    double errFix, errSim;
+    double mcFix = mcPrice(fixProd, spyc, npaths, errFix);
+    double mcSim = mcPrice(simProd, spyc, npaths, errSim);
+
+    bool ok = std::fabs(mcFix - pde) <= nStdErrors * errFix
+           && std::fabs(mcSim - pde) <= nStdErrors * errSim + c.simDatesTol * pde;
+    // the PDE solver must refuse the coarse simulation dates, which skip the monitoring dates
+    bool rejected = false;
+    try {
+      pdePrice(simProd, spyc, spvol);
+    }
+    catch (std::exception const&) {
+      rejected = true;
+    }
+    ok = ok && rejected;
+    failed += ok ? 0 : 1;
+    std::printf("%-16s %10.6f %10.6f %9.2e %10.6f %9.2e %s\n",
+                c.name, pde, mcFix, errFix, mcSim, errSim, ok ? "ok" : (rejected ? "FAILED" : "FAILED (pde)"));
+  }
+  return failed == 0 ? 0 : 1;
+}
+
+END_NAMESPACE(orf)
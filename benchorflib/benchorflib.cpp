@@ -0,0 +1,67 @@
+/**
+@file  benchorflib.cpp
+@brief Entry point of the benchorflib console program.
+
+The program is built by the benchorflib-vs15 project of the solution.
+On Linux it is built with g++ from this directory, against the same armadillo installation
+and the lapack and blas libraries armadillo is configured with:
+  g++ -std=c++14 -O2 -I.. -I<armadillo>/include $(find ../orflib -name '*.cpp') *.cpp \
+      -o benchorflib -pthread -llapack -lblas
+
+Usage: benchorflib <benchmark> [args...]
+*/
+
+#include <benchorflib/benchorflib.hpp>
+#include <orflib/exception.hpp>
+
+#include <iostream>
+#include <map>
+
+using namespace orf;
+
+namespace
+{
+  using BenchFunc = int(*)(std::vector<std::string> const&);
+
+  std::map<std::string, BenchFunc> const& benchmarks()
+  {
+    static std::map<std::string, BenchFunc> benchs = {
+      { "barriermcpde", &benchBarrierMcPde },
+      { "mcprecision", &benchMcPrecision },
+      { "pdeconvergence", &benchPdeConvergence }
+    };
+    return benchs;
+  }
+
+  void usage()
+  {
+    std::cout << "orflib " << ORF_VERSION_STRING << " benchmarks" << std::endl
+              << "Usage: benchorflib <benchmark> [args...]" << std::endl
+              << "Available benchmarks:" << std::endl;
+    for (auto const& b : benchmarks())
+      std::cout << "  " << b.first << std::endl;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    usage();
+    return 1;
+  }
+  auto it = benchmarks().find(argv[1]);
+  if (it == benchmarks().end()) {
+    std::cerr << "unknown benchmark " << argv[1] << std::endl;
+    usage();
+    return 1;
+  }
+
+  try {
+    std::vector<std::string> args(argv + 2, argv + argc);
+    return it->second(args);
+  }
+  catch (std::exception const& e) {
+    std::cerr << "error: " << e.what() << std::endl;
+    return 2;
+  }
+}
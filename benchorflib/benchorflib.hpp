@@ -0,0 +1,39 @@
+/**
+@file  benchorflib.hpp
+@brief Declaration of the benchmarks run by the benchorflib console program
+*/
+
+#ifndef ORF_BENCHORFLIB_HPP
+#define ORF_BENCHORFLIB_HPP
+
+#include <orflib/defines.hpp>
+#include <string>
+#include <vector>
+
+BEGIN_NAMESPACE(orf)
+
+/** Compares single and double precision Monte Carlo paths on a set of products.
+    For each product it reports both prices, their difference, the standard error
+    and the time spent in each simulation.
+    Arguments: [npaths]
+*/
+int benchMcPrecision(std::vector<std::string> const& args);
+
+/** Prices daily, weekly and monthly barrier options with the Monte Carlo pricer, both on the monitoring
+    dates and on nSimDates coarse simulation dates with the barrier crossing correction, and checks the prices
+    against a very fine PDE grid; also checks that the PDE solver rejects the coarse simulation dates.
+    Returns 1 if a check fails.
+    Arguments: [npaths] [nSimDates]
+*/
+int benchBarrierMcPde(std::vector<std::string> const& args);
+
+/** Solves European, American and barrier options with the 1-dim PDE solver on grids of
+    nTimeSteps, nSpotNodes, nStdDevs and theta, and reports the error against the closed-form
+    (or a very fine grid) price and the runtime of each solve, as CSV or JSON.
+    Arguments: [csv|json] [nTimeSteps,...] [nSpotNodes,...] [nStdDevs,...] [theta,...] [nrepeat]
+*/
+int benchPdeConvergence(std::vector<std::string> const& args);
+
+END_NAMESPACE(orf)
+
+#endif // ORF_BENCHORFLIB_HPP
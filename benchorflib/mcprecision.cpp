@@ -0,0 +1,120 @@
+/**
+@file  mcprecision.cpp
+@brief Benchmark of single vs double precision Monte Carlo path generation
+*/
+
+#include <benchorflib/benchorflib.hpp>
+#include <orflib/market/yieldcurve.hpp>
+#include <orflib/products/europeancallput.hpp>
+#include <orflib/products/asianbasketcallput.hpp>
+#include <orflib/pricers/bsmcpricer.hpp>
+#include <orflib/pricers/multiassetbsmcpricer.hpp>
+#include <orflib/math/stats/meanvarcalculator.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+
+BEGIN_NAMESPACE(orf)
+
+namespace
+{
+  struct McResult
+  {
+    double mean;
+    double stderror;
+    double seconds;
+  };
+
+  // Runs one simulation; the pricer is created inside so that both precisions
+  // start from the same seed and consume the same normal deviates.
+  template <typename PRICER>
+  McResult runMc(std::function<PRICER(McParams const&)> makePricer,
+                 McParams const& mcparams, unsigned long npaths)
+  {
+    auto start = std::chrono::steady_clock::now();
+    PRICER pricer = makePricer(mcparams);
+    MeanVarCalculator<double*> sc(pricer.nVariables());
+    pricer.simulate(sc, npaths);
+    auto stop = std::chrono::steady_clock::now();
+
+    Matrix const& results = sc.results();
+    McResult res;
+    res.mean = results(0, 0);
+    res.stderror = std::sqrt(results(1, 0) / sc.nSamples());
+    res.seconds = std::chrono::duration<double>(stop - start).count();
+    return res;
+  }
+
+  template <typename PRICER>
+  void compare(char const* name, std::function<PRICER(McParams const&)> makePricer,
+               McParams::UrngType urng, McParams::PathGenType pathgen, unsigned long npaths)
+  {
+    McParams dbl(urng, pathgen, McParams::PathPrecision::DOUBLE);
+    McParams sgl(urng, pathgen, McParams::PathPrecision::SINGLE);
+    McResult rd = runMc(makePricer, dbl, npaths);
+    McResult rs = runMc(makePricer, sgl, npaths);
+    double bias = std::fabs(rs.mean - rd.mean);
+    std::printf("%-28s %-6s %12.6f %12.6f %10.2e %10.2e %9.2e %8.3f %8.3f\n",
+                name, pathgen == McParams::PathGenType::EULER ? "euler" : "bridge",
+                rd.mean, rs.mean, bias, rd.stderror, bias / rd.stderror,
+                rd.seconds, rs.seconds);
+  }
+}
+
+int benchMcPrecision(std::vector<std::string> const& args)
+{
+  unsigned long npaths = args.empty() ? 100000 : std::stoul(args[0]);
+
+  // market data
+  double spot = 100.0, divyld = 0.02, vol = 0.2, rate = 0.05;
+  double maturity[] = { 10.0 };
+  double zerorate[] = { rate };
+  SPtrYieldCurve spyc(new YieldCurve(maturity, maturity + 1, zerorate, zerorate + 1));
+
+  // monthly fixings over two years
+  Vector fixings(24);
+  for (size_t i = 0; i < fixings.size(); ++i)
+    fixings[i] = (i + 1) / 12.0;
+
+  std::printf("npaths = %lu; bias = |single - double|, ratio = bias / stderror\n", npaths);
+  std::printf("%-28s %-6s %12s %12s %10s %10s %9s %8s %8s\n",
+              "product", "path", "double", "single", "bias", "stderror", "ratio",
+              "t_dbl(s)", "t_sgl(s)");
+
+  for (auto pathgen : { McParams::PathGenType::EULER, McParams::PathGenType::BROWNIANBRIDGE }) {
+    compare<BsMcPricer>("european call 1y",
+      [&](McParams const& mcp) {
+        SPtrProduct prod(new EuropeanCallPut(1, spot, 1.0));
+        return BsMcPricer(prod, spyc, divyld, vol, spot, mcp);
+      }, McParams::UrngType::MT19937, pathgen, npaths);
+
+    compare<BsMcPricer>("asian call 2y monthly",
+      [&](McParams const& mcp) {
+        Vector qty(1);
+        qty[0] = 1.0;
+        SPtrProduct prod(new AsianBasketCallPut(1, spot, fixings, qty));
+        return BsMcPricer(prod, spyc, divyld, vol, spot, mcp);
+      }, McParams::UrngType::MT19937, pathgen, npaths);
+
+    compare<MultiAssetBsMcPricer>("asian basket 3 assets 2y",
+      [&](McParams const& mcp) {
+        Vector qty(3), divs(3), vols(3), spots(3);
+        Matrix correl(3, 3);
+        for (size_t i = 0; i < 3; ++i) {
+          qty[i] = 1.0 / 3.0;
+          divs[i] = divyld;
+          vols[i] = vol + 0.05 * i;
+          spots[i] = spot;
+          for (size_t j = 0; j < 3; ++j)
+            correl(i, j) = i == j ? 1.0 : 0.5;
+        }
+        SPtrProduct prod(new AsianBasketCallPut(1, spot, fixings, qty));
+        return MultiAssetBsMcPricer(prod, spyc, divs, vols, spots, correl, mcp);
+      }, McParams::UrngType::MT19937, pathgen, npaths);
+  }
+  return 0;
+}
+
+END_NAMESPACE(orf)
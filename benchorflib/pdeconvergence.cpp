@@ -0,0 +1,205 @@
+/**
+@file  pdeconvergence.cpp
+@brief Benchmark of the accuracy vs the runtime of the 1-dim PDE solver
+*/
+
+#include <benchorflib/benchorflib.hpp>
+#include <orflib/market/yieldcurve.hpp>
+#include <orflib/market/volatilitytermstructure.hpp>
+#include <orflib/products/europeancallput.hpp>
+#include <orflib/products/americancallput.hpp>
+#include <orflib/products/barriercallput.hpp>
+#include <orflib/methods/pde/pde1dsolver.hpp>
+#include <orflib/pricers/simplepricers.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <limits>
+
+BEGIN_NAMESPACE(orf)
+
+namespace
+{
+  struct Case
+  {
+    std::string name;
+    std::function<SPtrProduct()> makeProduct;
+    double reference;
+    double refError;    // the estimated error of the reference, 0 for a closed form
+  };
+
+  struct Run
+  {
+    size_t icase;
+    size_t nTimeSteps, nSpotNodes;
+    double nStdDevs, theta;
+    double price, error, seconds;
+  };
+
+  // market data
+  double const spot = 100.0, strike = 100.0, divyld = 0.02, vol = 0.2, rate = 0.05, maturity = 1.0;
+
+  // Solves once and returns the price and the fastest of nrepeat runtimes
+  double solvePde(SPtrProduct prod, SPtrYieldCurve spyc, SPtrVolatilityTermStructure spvol,
+                  PdeParams const& params, size_t nrepeat, double& seconds)
+  {
+    double price = 0.0;
+    seconds = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < nrepeat; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      Pde1DResults results;
+      Pde1DSolver solver(prod, spyc, spot, divyld, spvol, results);
+      solver.solve(params);
+      auto stop = std::chrono::steady_clock::now();
+      seconds = std::min(seconds, std::chrono::duration<double>(stop - start).count());
+      price = results.prices[0];
+    }
+    return price;
+  }
+
+  PdeParams makeParams(size_t nTimeSteps, size_t nSpotNodes, double nStdDevs, double theta)
+  {
+    PdeParams params;
+    params.nTimeSteps = nTimeSteps;
+    params.nSpotNodes[0] = nSpotNodes;
+    params.nStdDevs[0] = nStdDevs;
+    params.theta = theta;
+    return params;
+  }
+
+  std::vector<double> parseList(std::string const& s)
+  {
+    std::vector<double> vals;
+    size_t pos = 0;
+    while (pos <= s.size()) {
+      size_t next = std::min(s.find(',', pos), s.size());
+      vals.push_back(std::stod(s.substr(pos, next - pos)));
+      pos = next + 1;
+    }
+    return vals;
+  }
+}
+
+int benchPdeConvergence(std::vector<std::string> const& args)
+{
+  std::string format = args.size() > 0 ? args[0] : "csv";
+  ORF_ASSERT(format == "csv" || format == "json", "pdeconvergence: the format must be csv or json!");
+  std::vector<double> timeSteps = args.size() > 1 ? parseList(args[1]) : std::vector<double>{ 25, 50, 100, 200, 400 };
+  std::vector<double> spotNodes = args.size() > 2 ? parseList(args[2]) : std::vector<double>{ 50, 100, 200, 400, 800 };
+  std::vector<double> stdDevs = args.size() > 3 ? parseList(args[3]) : std::vector<double>{ 3, 4, 5, 6 };
+  std::vector<double> thetas = args.size() > 4 ? parseList(args[4]) : std::vector<double>{ 0.5, 1.0 };
+  size_t nrepeat = args.size() > 5 ? std::stoul(args[5]) : 3;
+
+  double maturities[] = { maturity };
+  double zerorates[] = { rate };
+  double vols[] = { vol };
+  SPtrYieldCurve spyc(new YieldCurve(maturities, maturities + 1, zerorates, zerorates + 1));
+  SPtrVolatilityTermStructure spvol(new VolatilityTermStructure(maturities, maturities + 1, vols, vols + 1));
+
+  // the American put and the daily monitored barrier are priced against very fine grids; the closed form
+  // with the Broadie-Glasserman-Kou shifted barrier is biased by more than the finer tolerances.
+  // The error of each reference is estimated from the coarser grids
+  double barrier = 130.0;
+  std::vector<Case> cases = {
+    { "european call", [] { return SPtrProduct(new EuropeanCallPut(1, strike, maturity)); },
+      europeanOptionBS(1, spot, strike, maturity, rate, divyld, vol)[0], 0.0 },
+    { "european put", [] { return SPtrProduct(new EuropeanCallPut(-1, strike, maturity)); },
+      europeanOptionBS(-1, spot, strike, maturity, rate, divyld, vol)[0], 0.0 },
+    { "american put", [] { return SPtrProduct(new AmericanCallPut(-1, strike, maturity)); }, 0.0, 0.0 },
+    { "barrier uo call daily", [=] { return SPtrProduct(new BarrierCallPut(1, strike, barrier, "uo",
+                                                        BarrierCallPut::Freq::DAILY, maturity)); }, 0.0, 0.0 }
+  };
+  double seconds;
+  {
+    PdeParams fine = makeParams(8000, 8000, 6.0, 1.0), half = makeParams(4000, 4000, 6.0, 1.0);
+    fine.scheme = half.scheme = PdeParams::Scheme::RANNACHER;
+    cases[2].reference = solvePde(cases[2].makeProduct(), spyc, spvol, fine, 1, seconds);
+    double halfPrice = solvePde(cases[2].makeProduct(), spyc, spvol, half, 1, seconds);
+    cases[2].refError = std::fabs(cases[2].reference - halfPrice);
+  }
+  {
+    // the barrier jumps the price on every monitoring date, so the convergence is of first order in
+    // both steps; with a node on the barrier and ten steps a day it is regular enough to extrapolate
+    double prices[3];
+    for (size_t k = 0; k < 3; ++k) {
+      PdeParams params = makeParams(3650 << k, 4000 << k, 6.0, 1.0);
+      params.scheme = PdeParams::Scheme::RANNACHER;
+      params.nodeConcentration[0] = 20.0;
+      prices[k] = solvePde(cases[3].makeProduct(), spyc, spvol, params, 1, seconds);
+    }
+    cases[3].reference = 2.0 * prices[2] - prices[1];
+    cases[3].refError = std::fabs(cases[3].reference - (2.0 * prices[1] - prices[0]));
+  }
+
+  std::vector<Run> runs;
+  for (size_t ic = 0; ic < cases.size(); ++ic) {
+    SPtrProduct prod = cases[ic].makeProduct();
+    for (double theta : thetas)
+      for (double nstd : stdDevs)
+        for (double nt : timeSteps)
+          for (double nx : spotNodes) {
+            Run run = { ic, size_t(nt), size_t(nx), nstd, theta, 0.0, 0.0, 0.0 };
+            PdeParams params = makeParams(run.nTimeSteps, run.nSpotNodes, nstd, theta);
+            run.price = solvePde(prod, spyc, spvol, params, nrepeat, run.seconds);
+            run.error = std::fabs(run.price - cases[ic].reference);
+            runs.push_back(run);
+          }
+  }
+
+  // for each product and tolerance, the fastest run within the tolerance; the tolerances finer than
+  // the error of the reference are skipped, they would measure the reference
+  double const tolerances[] = { 1.0e-2, 1.0e-3, 1.0e-4 };
+  std::vector<std::pair<double, Run const*>> frontier;
+  for (size_t ic = 0; ic < cases.size(); ++ic)
+    for (double tol : tolerances) {
+      if (tol < cases[ic].refError)
+        continue;
+      Run const* best = nullptr;
+      for (Run const& run : runs)
+        if (run.icase == ic && run.error <= tol && (!best || run.seconds < best->seconds))
+          best = &run;
+      if (best)
+        frontier.push_back(std::make_pair(tol, best));
+    }
+
+  if (format == "csv") {
+    std::printf("product,nTimeSteps,nSpotNodes,nStdDevs,theta,cost,price,reference,referror,abserror,seconds\n");
+    for (Run const& r : runs)
+      std::printf("%s,%zu,%zu,%g,%g,%zu,%.10f,%.10f,%.3e,%.3e,%.3e\n", cases[r.icase].name.c_str(),
+                  r.nTimeSteps, r.nSpotNodes, r.nStdDevs, r.theta, r.nTimeSteps * r.nSpotNodes,
+                  r.price, cases[r.icase].reference, cases[r.icase].refError, r.error, r.seconds);
+    std::printf("\nproduct,tolerance,nTimeSteps,nSpotNodes,nStdDevs,theta,abserror,seconds\n");
+    for (auto const& f : frontier) {
+      Run const& r = *f.second;
+      std::printf("%s,%g,%zu,%zu,%g,%g,%.3e,%.3e\n", cases[r.icase].name.c_str(), f.first,
+                  r.nTimeSteps, r.nSpotNodes, r.nStdDevs, r.theta, r.error, r.seconds);
+    }
+  }
+  else {
+    std::printf("{\n  \"runs\": [\n");
+    for (size_t i = 0; i < runs.size(); ++i) {
+      Run const& r = runs[i];
+      std::printf("    {\"product\": \"%s\", \"nTimeSteps\": %zu, \"nSpotNodes\": %zu, \"nStdDevs\": %g, "
+                  "\"theta\": %g, \"cost\": %zu, \"price\": %.10f, \"reference\": %.10f, "
+                  "\"referror\": %.3e, \"abserror\": %.3e, \"seconds\": %.3e}%s\n", cases[r.icase].name.c_str(),
+                  r.nTimeSteps, r.nSpotNodes, r.nStdDevs, r.theta, r.nTimeSteps * r.nSpotNodes,
+                  r.price, cases[r.icase].reference, cases[r.icase].refError, r.error, r.seconds,
+                  i + 1 < runs.size() ? "," : "");
+    }
+    std::printf("  ],\n  \"frontier\": [\n");
+    for (size_t i = 0; i < frontier.size(); ++i) {
+      Run const& r = *frontier[i].second;
+      std::printf("    {\"product\": \"%s\", \"tolerance\": %g, \"nTimeSteps\": %zu, \"nSpotNodes\": %zu, "
+                  "\"nStdDevs\": %g, \"theta\": %g, \"abserror\": %.3e, \"seconds\": %.3e}%s\n",
+                  cases[r.icase].name.c_str(), frontier[i].first, r.nTimeSteps, r.nSpotNodes,
+                  r.nStdDevs, r.theta, r.error, r.seconds, i + 1 < frontier.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+  }
+  return 0;
+}
+
+END_NAMESPACE(orf)
@@ -73,4 +73,16 @@ double VolatilityTermStructure::fwdVol(double tMat1, double tMat2) const
   return std::sqrt(fvar / (tMat2 - tMat1));  // return the annualized volatility
 }
 
+VolatilityTermStructure VolatilityTermStructure::shifted(double volBump) const
+{
+  // the forward vols with their end times; the last one is flat beyond its start
+  size_t n = fwdvars_.size();
+  Vector mats(n), fwdvols(n);
+  for (size_t i = 0; i < n; ++i) {
+    mats[i] = i + 1 < n ? fwdvars_.breakPoint(i + 1) : fwdvars_.breakPoint(i) + 1.0;
+    fwdvols[i] = std::sqrt(fwdvars_.coefficient(0, i)) + volBump;
+  }
+  return VolatilityTermStructure(mats.begin(), mats.end(), fwdvols.begin(), fwdvols.end(), VolType::FWDVOL);
+}
+
 END_NAMESPACE(orf)
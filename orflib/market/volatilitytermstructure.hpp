@@ -33,6 +33,9 @@ public:
   /** Returns the forward rate between times tMat1 and tMat2 */
   double fwdVol(double tMat1, double tMat2) const;
 
+  /** Returns a copy with all forward volatilities shifted by volBump, e.g. for the vega */
+  VolatilityTermStructure shifted(double volBump) const;
+
 protected:
 private:
   // helper functions
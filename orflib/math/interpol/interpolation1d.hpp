@@ -13,10 +13,11 @@
 #include <cmath>
 #include <algorithm>
 #include <functional>
+#include <vector>
 
 BEGIN_NAMESPACE(orf)
 
-/** Helper function for finding the bracketing indices of a value in an ordered vector */
+/** Helper function for finding the bracketing indices of a value in an ordered vector, by binary search */
 template <typename ARRAY>
 void findIndices(ARRAY const& v, double y, size_t& i1, size_t& i2)
 {
@@ -29,27 +30,133 @@ void findIndices(ARRAY const& v, double y, size_t& i1, size_t& i2)
     return;
   }
 
-  for (size_t i = 1; i < v.size(); ++i) {
-    if (y == v[i]) {
-      i1 = i2 = i;
-      return;
+  // now v[1] < y < v[n - 2]; find the first node not below y
+  size_t lo = 1, hi = v.size() - 2;
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (v[mid] < y)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  if (y == v[hi]) {
+    i1 = i2 = hi;
+    return;
+  }
+  i1 = hi - 1;
+  i2 = hi;
+}
+
+/** A read-only view of n contiguous doubles, e.g. a column of a Matrix.
+    The interpolators can take it as their ARRAY of y values, so that the values are not copied.
+*/
+class ArrayView
+{
+public:
+  /** Ctor from the first value and the number of values */
+  ArrayView(double const* data, size_t n) : data_(data), n_(n) {}
+
+  size_t size() const { return n_; }
+  double operator[](size_t i) const { return data_[i]; }
+  double const* begin() const { return data_; }
+  double const* end() const { return data_ + n_; }
+
+private:
+  double const* data_;
+  size_t n_;
+};
+
+/** Finds the interval of an increasing vector of nodes that contains a value:
+    in O(1) if the nodes are uniformly spaced, as on the axes of uniform PDE grids,
+    otherwise by binary search. It keeps a reference to the nodes.
+*/
+template <typename ARRAY>
+class IntervalLocator
+{
+public:
+  /** Ctor from the nodes; there must be at least two */
+  explicit IntervalLocator(ARRAY const& xvals)
+    : xvals_(xvals), n_(xvals.size())
+  {
+    ORF_ASSERT(n_ > 1, "IntervalLocator: need at least two nodes!");
+    x0_ = xvals[0];
+    double dx = (xvals[n_ - 1] - x0_) / (n_ - 1);
+    ORF_ASSERT(dx > 0.0, "IntervalLocator: the nodes must be increasing!");
+    uniform_ = true;
+    for (size_t i = 1; i < n_ - 1 && uniform_; ++i)
+      uniform_ = std::fabs(xvals[i] - (x0_ + i * dx)) <= 1.0e-10 * dx;
+    invDX_ = 1.0 / dx;
+  }
+
+  /** Returns true if the nodes are uniformly spaced */
+  bool isUniform() const { return uniform_; }
+
+  /** Returns the index i of the interval [x_i, x_{i+1}) that contains x,
+      0 left of the nodes and n - 2 from the last node on
+  */
+  size_t interval(double x) const
+  {
+    if (uniform_) {
+      double r = (x - x0_) * invDX_;
+      size_t i = r <= 0.0 ? 0 : r >= double(n_ - 2) ? n_ - 2 : size_t(r);
+      // the rounding may be one node off
+      if (i > 0 && x < xvals_[i])
+        --i;
+      else if (i < n_ - 2 && x >= xvals_[i + 1])
+        ++i;
+      return i;
+    }
+    size_t lo = 0, hi = n_ - 1;
+    while (hi - lo > 1) {
+      size_t mid = (lo + hi) / 2;
+      if (x < xvals_[mid])
+        hi = mid;
+      else
+        lo = mid;
     }
-    if (y < v[i]) {
-      i1 = i - 1;
-      i2 = i;
+    return lo;
+  }
+
+  /** Sets idx[k] to interval(xs[k]) for the increasing query points xs,
+      sweeping once through the nodes if they are not uniform
+  */
+  template <typename QARRAY>
+  void intervals(QARRAY const& xs, std::vector<size_t>& idx) const
+  {
+    idx.resize(xs.size());
+    if (xs.size() == 0)
       return;
+    size_t i = interval(xs[0]);
+    for (size_t k = 0; k < xs.size(); ++k) {
+      ORF_ASSERT(k == 0 || xs[k] >= xs[k - 1], "IntervalLocator: the query points must be increasing!");
+      if (uniform_)
+        i = interval(xs[k]);
+      else
+        while (i < n_ - 2 && xs[k] >= xvals_[i + 1])
+          ++i;
+      idx[k] = i;
     }
   }
-}
 
-/** The linear interpolator class */
+private:
+  ARRAY const& xvals_;
+  size_t n_;
+  double x0_;
+  double invDX_;      // the inverse of the uniform spacing
+  bool uniform_;
+};
+
+/** The linear interpolator class.
+    It keeps references to the x and y values, which must outlive it; pass an ArrayView
+    to interpolate e.g. a column of a matrix.
+*/
 template <typename ARRAY>
 class LinearInterpolation1D
 {
 public:
   /** Initializing ctor */
   LinearInterpolation1D(Vector const& xvals, ARRAY const& yvals)
-    : xvals_(xvals), yvals_(yvals)
+    : xvals_(xvals), yvals_(yvals), locator_(xvals)
   {
     ORF_ASSERT(xvals.size() == yvals.size(), "LinearInterpolation1D: unequal vector sizes!");
   }
@@ -78,22 +185,188 @@ public:
   */
   double getValue(double x) const
   {
-    size_t i1, i2;
-    findIndices(xvals_, x, i1, i2);
-    double y1, y2;
-    y1 = getValue(i1);
-    if (i2 == i1) {
+    return valueInInterval(locator_.interval(x), x);
+  }
+
+  /** Sets ys to the interpolated values at the increasing points xs */
+  void getValues(Vector const& xs, Vector& ys) const
+  {
+    std::vector<size_t> idx;
+    locator_.intervals(xs, idx);
+    ys.resize(xs.size());
+    for (size_t k = 0; k < xs.size(); ++k)
+      ys[k] = valueInInterval(idx[k], xs[k]);
+  }
+
+protected:
+
+  double valueInInterval(size_t i, double x) const
+  {
+    double y1 = getValue(i);
+    double x1 = xvals_[i];
+    if (x == x1)
       return y1;
-    }
-    y2 = getValue(i2);
-    double x1 = xvals_[i1], x2 = xvals_[i2];
+    double y2 = getValue(i + 1), x2 = xvals_[i + 1];
     return y1 + (y2 - y1) * (x - x1) / (x2 - x1);
   }
 
-protected:
+  Vector const& xvals_;
+  ARRAY  const& yvals_;
+  IntervalLocator<Vector> locator_;
+
+};
+
+/** The cubic spline interpolator class.
+    The NATURAL spline has continuous second derivatives, which vanish at the end nodes.
+    The MONOTONE spline has the Fritsch-Butland slopes, so that it is monotone wherever the values are,
+    with continuous first derivatives only. Both extrapolate linearly with the slopes at the end nodes.
+    It keeps references to the x and y values, which must outlive it, and stores only the slopes.
+*/
+template <typename ARRAY>
+class CubicSplineInterpolation1D
+{
+public:
+  enum class Type
+  {
+    NATURAL,
+    MONOTONE
+  };
+
+  /** Initializing ctor */
+  CubicSplineInterpolation1D(Vector const& xvals, ARRAY const& yvals, Type type = Type::NATURAL)
+    : xvals_(xvals), yvals_(yvals), locator_(xvals)
+  {
+    ORF_ASSERT(xvals.size() == yvals.size(), "CubicSplineInterpolation1D: unequal vector sizes!");
+    if (type == Type::NATURAL)
+      setNaturalSlopes();
+    else
+      setMonotoneSlopes();
+  }
+
+  Vector const& xValues() const { return xvals_; }
+
+  ARRAY const& yValues() const { return yvals_; }
+
+  /** The first derivatives at the nodes */
+  Vector const& slopes() const { return slopes_; }
+
+  /** Returns the interpolated value at x */
+  double getValue(double x) const
+  {
+    return valueInInterval(locator_.interval(x), x, 0);
+  }
+
+  /** Returns the k-th derivative at x, for k = 1 or 2 */
+  double getDerivative(double x, size_t k = 1) const
+  {
+    ORF_ASSERT(k == 1 || k == 2, "CubicSplineInterpolation1D: only the first two derivatives are available!");
+    return valueInInterval(locator_.interval(x), x, k);
+  }
+
+  /** Sets ys to the interpolated values at the increasing points xs */
+  void getValues(Vector const& xs, Vector& ys) const
+  {
+    std::vector<size_t> idx;
+    locator_.intervals(xs, idx);
+    ys.resize(xs.size());
+    for (size_t k = 0; k < xs.size(); ++k)
+      ys[k] = valueInInterval(idx[k], xs[k], 0);
+  }
+
+private:
+
+  // the value or k-th derivative of the cubic Hermite piece on the interval i, linear outside the nodes
+  double valueInInterval(size_t i, double x, size_t k) const
+  {
+    size_t n = xvals_.size();
+    if (x < xvals_[0] || x > xvals_[n - 1]) {
+      size_t e = x < xvals_[0] ? 0 : n - 1;
+      return k == 0 ? yvals_[e] + slopes_[e] * (x - xvals_[e]) : k == 1 ? slopes_[e] : 0.0;
+    }
+    double h = xvals_[i + 1] - xvals_[i];
+    double t = (x - xvals_[i]) / h;
+    double y0 = yvals_[i], y1 = yvals_[i + 1];
+    double m0 = slopes_[i] * h, m1 = slopes_[i + 1] * h;
+    if (k == 0)
+      return y0 * (1.0 + 2.0 * t) * (1.0 - t) * (1.0 - t) + m0 * t * (1.0 - t) * (1.0 - t)
+           + y1 * t * t * (3.0 - 2.0 * t) - m1 * t * t * (1.0 - t);
+    if (k == 1)
+      return (6.0 * t * (t - 1.0) * (y0 - y1) + m0 * (1.0 - t) * (1.0 - 3.0 * t)
+            + m1 * t * (3.0 * t - 2.0)) / h;
+    return (6.0 * (2.0 * t - 1.0) * (y0 - y1) + m0 * (6.0 * t - 4.0) + m1 * (6.0 * t - 2.0)) / (h * h);
+  }
+
+  // the slopes of the C2 spline with zero second derivatives at the ends, by the Thomas algorithm
+  void setNaturalSlopes()
+  {
+    size_t n = xvals_.size();
+    slopes_.zeros(n);
+    Vector c(n);      // the eliminated upper diagonal
+    double cPrev = 0.0, dPrev = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+      double hl = i > 0 ? xvals_[i] - xvals_[i - 1] : 0.0;
+      double hr = i + 1 < n ? xvals_[i + 1] - xvals_[i] : 0.0;
+      double sl = i > 0 ? (yvals_[i] - yvals_[i - 1]) / hl : 0.0;
+      double sr = i + 1 < n ? (yvals_[i + 1] - yvals_[i]) / hr : 0.0;
+      // hr s_{i-1} + 2 (hl + hr) s_i + hl s_{i+1} = 3 (hr sl + hl sr), with the end rows divided by h
+      double lower, diag, upper, rhs;
+      if (i == 0) {
+        lower = 0.0; diag = 2.0; upper = 1.0; rhs = 3.0 * sr;
+      }
+      else if (i == n - 1) {
+        lower = 1.0; diag = 2.0; upper = 0.0; rhs = 3.0 * sl;
+      }
+      else {
+        lower = hr; diag = 2.0 * (hl + hr); upper = hl; rhs = 3.0 * (hr * sl + hl * sr);
+      }
+      double m = diag - lower * cPrev;
+      c[i] = upper / m;
+      slopes_[i] = (rhs - lower * dPrev) / m;
+      cPrev = c[i];
+      dPrev = slopes_[i];
+    }
+    for (size_t i = n - 1; i-- > 0;)
+      slopes_[i] -= c[i] * slopes_[i + 1];
+  }
+
+  // the Fritsch-Butland slopes, the weighted harmonic means of the neighboring secant slopes
+  void setMonotoneSlopes()
+  {
+    size_t n = xvals_.size();
+    slopes_.zeros(n);
+    std::vector<double> h(n - 1), d(n - 1);
+    for (size_t i = 0; i + 1 < n; ++i) {
+      h[i] = xvals_[i + 1] - xvals_[i];
+      d[i] = (yvals_[i + 1] - yvals_[i]) / h[i];
+    }
+    if (n == 2) {
+      slopes_[0] = slopes_[1] = d[0];
+      return;
+    }
+    for (size_t i = 1; i + 1 < n; ++i) {
+      if (d[i - 1] * d[i] > 0.0)
+        slopes_[i] = 3.0 * (h[i - 1] + h[i])
+                   / ((2.0 * h[i] + h[i - 1]) / d[i - 1] + (h[i] + 2.0 * h[i - 1]) / d[i]);
+    }
+    slopes_[0] = endSlope(h[0], h[1], d[0], d[1]);
+    slopes_[n - 1] = endSlope(h[n - 2], h[n - 3], d[n - 2], d[n - 3]);
+  }
+
+  // the shape preserving three-point slope at an end node
+  static double endSlope(double h0, double h1, double d0, double d1)
+  {
+    double s = ((2.0 * h0 + h1) * d0 - h0 * d1) / (h0 + h1);
+    if (s * d0 <= 0.0)
+      return 0.0;
+    if (d0 * d1 <= 0.0 && std::fabs(s) > std::fabs(3.0 * d0))
+      return 3.0 * d0;
+    return s;
+  }
 
   Vector const& xvals_;
   ARRAY  const& yvals_;
+  IntervalLocator<Vector> locator_;
+  Vector slopes_;
 
 };
 
@@ -27,19 +27,7 @@ double PiecewisePolynomial::operator()(double x) const
 
 double PiecewisePolynomial::eval(double x, size_t k) const
 {
-  size_t n(size());
-  double val;
-
-  if (x < x_(0))			// the point x is to the left x_[0]
-    val = (k == 0) ? c_(0, 0) : 0.0;   // flat extrapolation
-  else if (x_(n - 1) <= x)
-    val = (k == 0) ? c_(0, n - 1) : 0.0;   // flat extrapolation
-  else {
-    size_t idx = index(x);
-    val = derivative(idx, x - x_(idx), k);
-  }
-
-  return val;
+  return evalAtIndex(index(x), x, k);
 }
 
 double PiecewisePolynomial::integral(double a, double b) const
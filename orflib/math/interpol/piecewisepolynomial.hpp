@@ -91,6 +91,7 @@ public:
         It assumes that [yFirst, yFirst + (xLast - xFirst)) is a valid range.
         k = 0 : y(x)
         k > 0 : k-th left derivative at x
+        Increasing runs of x are located by sweeping through the breakpoints.
   */
   template<typename XITER, typename YITER>
   void eval(XITER const xFirst, XITER const xLast, YITER yFirst, size_t k = 0) const;
@@ -148,6 +149,16 @@ protected:
     return std::upper_bound(x_.begin(), x_.end(), x) - x_.begin() - 1;
   }
 
+  // Returns the value or k-th derivative at x, given idx = index(x)
+  inline double evalAtIndex(ptrdiff_t idx, double x, size_t k) const
+  {
+    if (idx < 0)                                 // the point x is to the left x_[0]
+      return (k == 0) ? c_(0, 0) : 0.0;         // flat extrapolation
+    if (idx >= ptrdiff_t(size()) - 1)
+      return (k == 0) ? c_(0, size() - 1) : 0.0;   // flat extrapolation
+    return derivative(idx, x - x_(idx), k);
+  }
+
   // Helper function for computing factorials
   inline size_t factorial(size_t n) const {
     return n == 0 ? 1 : n * factorial(n - 1);
@@ -263,9 +274,19 @@ inline void PiecewisePolynomial::eval(XITER xFirst,
 
   XITER xit = xFirst;
   YITER yit = yFirst;
-  for (; xit < xLast; ++xit, ++yit)
-    *yit = eval(*xit, k);
-
+  ptrdiff_t n = size();
+  ptrdiff_t idx = 0;
+  double xprev = 0.0;
+  for (; xit < xLast; ++xit, ++yit) {
+    double x = *xit;
+    if (xit == xFirst || x < xprev)
+      idx = index(x);   // the first point, or not increasing: search again
+    else
+      while (idx + 1 < n && x_(idx + 1) <= x)
+        ++idx;
+    xprev = x;
+    *yit = evalAtIndex(idx, x, k);
+  }
 }
 
 template<typename XITER, typename YITER>
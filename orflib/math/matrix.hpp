@@ -22,6 +22,16 @@ using RowVector = arma::rowvec;
 */
 using Matrix = arma::mat;
 
+/** The orf::FVector class is an alias for the armadillo column vector of floats.
+    Used by the single precision Monte Carlo path pipeline.
+*/
+using FVector = arma::fvec;
+
+/** The orf::FMatrix class is an alias for the armadillo matrix of floats, stored column-wise.
+    Used by the single precision Monte Carlo path pipeline.
+*/
+using FMatrix = arma::fmat;
+
 END_NAMESPACE(orf)
 
 #endif // ORF_MATRIX_HPP
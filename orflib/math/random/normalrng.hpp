@@ -11,11 +11,15 @@
 #include <orflib/exception.hpp>
 #include <random>
 #include <orflib/math/random/sobolurng.hpp>
+#include <orflib/math/random/ziggurat.hpp>
 #include <orflib/math/stats/normaldistribution.hpp>
 
 BEGIN_NAMESPACE(orf)
 
-/** Generator of normal deviates. It is templatized on the underlying uniform RNG
+/** Generator of normal deviates. It is templatized on the underlying uniform RNG.
+    Pseudo-random engines are transformed with the Ziggurat method, which only depends
+    on the engine output and gives the same deviates with every compiler.
+    The Sobol generator uses the inverse normal cdf, to preserve the low discrepancy.
 */
 template<typename URNG>
 class NormalRng
@@ -29,7 +33,7 @@ public:
   size_t dim() const;
 
   /** Returns a batch of random deviates
-      CAUTION: it requires end - begin == dimension() */
+      CAUTION: for the Sobol generator it requires end - begin to be a divisor of dimension() */
   template <typename ITER>
   void next(ITER begin, ITER end);
 
@@ -41,7 +45,9 @@ private:
   // state
   size_t dim_;      // the dimension of the generator
   URNG urng_;       // the uniform random number generator
-  std::normal_distribution<double> normcdf_;  // the normal distribution
+  double mean_;     // the mean of the deviates
+  double stdev_;    // the standard deviation of the deviates
+  ZigguratNormal zignor_;  // the transform from uniform to standard normal deviates
 
 };
 
@@ -50,10 +56,9 @@ private:
 
 template<typename URNG>
 NormalRng<URNG>::NormalRng(size_t dimension, double mean, double stdev)
-  : dim_(dimension)
+  : dim_(dimension), mean_(mean), stdev_(stdev)
 {
   ORF_ASSERT(stdev > 0.0, "the standard deviation must be positive!");
-  normcdf_ = std::normal_distribution<double>(mean, stdev);
 }
 
 template<typename URNG>
@@ -66,8 +71,11 @@ template<typename URNG>
 template <typename ITER>
 void NormalRng<URNG>::next(ITER begin, ITER end)
 {
-  for (ITER it = begin; it != end; ++it)
-    *it = normcdf_(urng_);
+  zignor_.generate(urng_, begin, end);
+  if (mean_ != 0.0 || stdev_ != 1.0) {
+    for (ITER it = begin; it != end; ++it)
+      *it = mean_ + stdev_ * *it;
+  }
 }
 
 template<typename URNG>
@@ -79,10 +87,9 @@ URNG & NormalRng<URNG>::urng()
 template<>
 inline
 NormalRng<SobolURng>::NormalRng(size_t dimension, double mean, double stdev)
-: dim_(dimension), urng_(dimension)
+: dim_(dimension), urng_(dimension), mean_(mean), stdev_(stdev)
 {
   ORF_ASSERT(stdev > 0.0, "the standard deviation must be positive!");
-  normcdf_ = std::normal_distribution<double>(mean, stdev);
 }
 
 template<>
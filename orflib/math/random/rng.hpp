@@ -8,6 +8,8 @@
 
 #include <orflib/math/random/normalrng.hpp>
 #include <orflib/math/random/sobolurng.hpp>
+#include <orflib/math/random/xoshiro256.hpp>
+#include <type_traits>
 
 BEGIN_NAMESPACE(orf)
 
@@ -22,9 +24,22 @@ using NormalRngRanLux3 = NormalRng<std::ranlux24>;
 
 /** RanLux level 4 */
 using NormalRngRanLux4 = NormalRng<std::ranlux48>;
+
+/** Xoshiro256++ */
+using NormalRngXoshiro256 = NormalRng<orf::Xoshiro256pp>;
+
 /** Sobol */
 using NormalRngSobol = NormalRng<orf::SobolURng>;
 
+/** True for low discrepancy generators, whose deviates must be drawn one full point
+    (all dimensions) at a time, i.e. they cannot be drawn time step by time step.
+*/
+template <typename NRNG>
+struct IsLowDiscrepancy : std::false_type {};
+
+template <>
+struct IsLowDiscrepancy<NormalRngSobol> : std::true_type {};
+
 END_NAMESPACE(orf)
 
 #endif // ORF_RNG_HPP
@@ -0,0 +1,208 @@
+/**
+@file  xoshiro256.hpp
+@brief The xoshiro256++ uniform random engine, with interleaved lanes and jump-ahead
+*/
+
+#ifndef ORF_XOSHIRO256_HPP
+#define ORF_XOSHIRO256_HPP
+
+#include <orflib/defines.hpp>
+#include <orflib/math/random/ziggurat.hpp>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+BEGIN_NAMESPACE(orf)
+
+/** The xoshiro256++ generator of Blackman and Vigna, period 2^256 - 1.
+    It runs LANES independent xoshiro256++ streams, spaced 2^128 steps apart,
+    and interleaves their outputs. The state is stored lane by lane so that the
+    update of all lanes in fill() is a straight loop the compiler can vectorize.
+    It satisfies the requirements of a std uniform random bit generator.
+*/
+class Xoshiro256pp
+{
+public:
+  /** Required for compatibility with std generators */
+  using result_type = uint64_t;
+
+  /** Number of interleaved streams */
+  enum { LANES = 4 };
+
+  /** Ctor from a seed, expanded to the full state with splitmix64 */
+  explicit Xoshiro256pp(uint64_t seed = DEFAULT_SEED);
+
+  /** Reseeds the generator */
+  void seed(uint64_t seed = DEFAULT_SEED);
+
+  /** Smallest value returned */
+  static constexpr result_type min() { return 0; }
+  /** Largest value returned */
+  static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+  /** Returns the next 64 random bits */
+  result_type operator()();
+
+  /** Returns the next 32 random bits; each 64-bit output supplies two of them */
+  uint32_t next32();
+
+  /** Fills [begin, end) with 64-bit outputs, LANES at a time */
+  void fill(result_type* begin, result_type* end);
+
+  /** Advances every lane by 2^192 steps. Calling it k times on copies of the same
+      generator gives up to 2^64 non-overlapping substreams, e.g. one per parallel worker.
+  */
+  void jump();
+
+private:
+  static const uint64_t DEFAULT_SEED = 5489u;
+  enum { BUFSIZE = 16 * LANES };
+
+  static uint64_t rotl(uint64_t x, int k);
+  // applies the jump polynomial poly to lane l
+  void jumpLane(size_t l, uint64_t const poly[4]);
+  // advances all lanes by one step and writes one output per lane
+  void step(result_type* out);
+
+  uint64_t s_[4][LANES];        // the state words, lane by lane
+  result_type buf_[BUFSIZE];    // outputs generated in bulk, served by operator()
+  size_t pos_;                  // the next unused output in buf_
+  uint32_t half_;               // the unused high half of the last output, for next32()
+  bool hasHalf_;
+};
+
+/** 32-bit words from xoshiro256++ use both halves of each output */
+template <>
+class UniformBits<Xoshiro256pp>
+{
+public:
+  static uint32_t next32(Xoshiro256pp& urng) { return urng.next32(); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline uint64_t Xoshiro256pp::rotl(uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+inline Xoshiro256pp::Xoshiro256pp(uint64_t seed)
+{
+  this->seed(seed);
+}
+
+inline void Xoshiro256pp::seed(uint64_t seed)
+{
+  // splitmix64 for the first lane
+  uint64_t z = seed;
+  for (size_t w = 0; w < 4; ++w) {
+    z += 0x9e3779b97f4a7c15ULL;
+    uint64_t x = z;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    s_[w][0] = x ^ (x >> 31);
+  }
+  // each next lane starts 2^128 steps after the previous one
+  static const uint64_t JUMP128[4] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                       0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+  for (size_t l = 1; l < LANES; ++l) {
+    for (size_t w = 0; w < 4; ++w)
+      s_[w][l] = s_[w][l - 1];
+    jumpLane(l, JUMP128);
+  }
+  pos_ = BUFSIZE;
+  half_ = 0;
+  hasHalf_ = false;
+}
+
+inline void Xoshiro256pp::step(result_type* out)
+{
+  for (size_t l = 0; l < LANES; ++l) {
+    uint64_t s0 = s_[0][l], s1 = s_[1][l], s2 = s_[2][l], s3 = s_[3][l];
+    out[l] = rotl(s0 + s3, 23) + s0;
+    uint64_t t = s1 << 17;
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    s3 = rotl(s3, 45);
+    s_[0][l] = s0; s_[1][l] = s1; s_[2][l] = s2; s_[3][l] = s3;
+  }
+}
+
+inline void Xoshiro256pp::fill(result_type* begin, result_type* end)
+{
+  // serve what is left in the buffer first, to keep a single output sequence
+  while (pos_ < BUFSIZE && begin != end)
+    *begin++ = buf_[pos_++];
+  while (end - begin >= LANES) {
+    step(begin);
+    begin += LANES;
+  }
+  if (begin != end) {
+    pos_ = BUFSIZE - LANES;
+    step(buf_ + pos_);
+    while (begin != end)
+      *begin++ = buf_[pos_++];
+  }
+}
+
+inline Xoshiro256pp::result_type Xoshiro256pp::operator()()
+{
+  if (pos_ == BUFSIZE) {
+    for (size_t k = 0; k < BUFSIZE; k += LANES)
+      step(buf_ + k);
+    pos_ = 0;
+  }
+  return buf_[pos_++];
+}
+
+inline uint32_t Xoshiro256pp::next32()
+{
+  if (hasHalf_) {
+    hasHalf_ = false;
+    return half_;
+  }
+  uint64_t x = (*this)();
+  half_ = static_cast<uint32_t>(x >> 32);
+  hasHalf_ = true;
+  return static_cast<uint32_t>(x);
+}
+
+inline void Xoshiro256pp::jumpLane(size_t l, uint64_t const poly[4])
+{
+  uint64_t j[4] = { 0, 0, 0, 0 };
+  for (size_t p = 0; p < 4; ++p) {
+    for (int b = 0; b < 64; ++b) {
+      if (poly[p] & (uint64_t(1) << b))
+        for (size_t w = 0; w < 4; ++w)
+          j[w] ^= s_[w][l];
+      // one step of lane l, output discarded
+      uint64_t t = s_[1][l] << 17;
+      s_[2][l] ^= s_[0][l];
+      s_[3][l] ^= s_[1][l];
+      s_[1][l] ^= s_[2][l];
+      s_[0][l] ^= s_[3][l];
+      s_[2][l] ^= t;
+      s_[3][l] = rotl(s_[3][l], 45);
+    }
+  }
+  for (size_t w = 0; w < 4; ++w)
+    s_[w][l] = j[w];
+}
+
+inline void Xoshiro256pp::jump()
+{
+  static const uint64_t JUMP192[4] = { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+                                       0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+  for (size_t l = 0; l < LANES; ++l)
+    jumpLane(l, JUMP192);
+  pos_ = BUFSIZE;
+  hasHalf_ = false;
+}
+
+END_NAMESPACE(orf)
+
+#endif // ORF_XOSHIRO256_HPP
@@ -0,0 +1,222 @@
+/**
+@file  ziggurat.hpp
+@brief Ziggurat transform of uniform random bits to standard normal deviates
+*/
+
+#ifndef ORF_ZIGGURAT_HPP
+#define ORF_ZIGGURAT_HPP
+
+#include <orflib/defines.hpp>
+#include <cmath>
+#include <cstdint>
+
+BEGIN_NAMESPACE(orf)
+
+/** Extracts uniformly distributed 32-bit words from a uniform random engine.
+    Only the engine output is used, which the standard specifies exactly,
+    so the words are the same with every compiler and standard library.
+    Engines with fewer than 32 bits per call (e.g. minstd_rand, ranlux24) are called
+    as many times as needed; the low bits of wider engines are used.
+*/
+template <typename URNG>
+class UniformBits
+{
+public:
+  /** Returns the next 32 uniform random bits */
+  static uint32_t next32(URNG& urng);
+
+private:
+  using result_type = typename URNG::result_type;
+
+  // number of full random bits returned by one call to the engine
+  static constexpr int bitsPerCall()
+  {
+    return log2floor(static_cast<unsigned long long>(URNG::max() - URNG::min()) + 1ULL);
+  }
+
+  static constexpr int log2floor(unsigned long long n)
+  {
+    return n <= 1 ? (n == 0 ? 64 : 0) : 1 + log2floor(n >> 1);
+  }
+};
+
+/** Generator of standard normal deviates with the Ziggurat method of Marsaglia and Tsang,
+    in the version of Doornik (2005), with 128 layers.
+    The layer index and the uniform within the layer come from independent random bits.
+    About 98.8% of the deviates take the fast path, costing 1.25 32-bit words and
+    one multiplication each.
+*/
+class ZigguratNormal
+{
+public:
+  /** Default ctor */
+  ZigguratNormal();
+
+  /** Returns the next standard normal deviate */
+  template <typename URNG>
+  double operator()(URNG& urng);
+
+  /** Fills [begin, end) with standard normal deviates */
+  template <typename URNG, typename ITER>
+  void generate(URNG& urng, ITER begin, ITER end);
+
+  /** Discards the cached layer index bits */
+  void reset();
+
+private:
+  enum { NLAYERS = 128 };
+
+  // the layer boundaries and ratios, computed once
+  struct Tables
+  {
+    Tables();
+    double x[NLAYERS + 1];   // the right edges of the layers; x[0] = V / f(R) for the base layer
+    double r[NLAYERS];       // x[i+1] / x[i], the fraction of layer i inside the curve
+  };
+  static Tables const& tables();
+
+  // returns the next layer index, drawing 4 indices from each 32-bit word
+  template <typename URNG>
+  unsigned nextLayer(URNG& urng);
+
+  // the slow path: the tail or the wedge of layer i, for the uniform u in (-1, 1)
+  template <typename URNG>
+  double slowPath(URNG& urng, unsigned i, double u);
+
+  // returns a uniform double in (0, 1), never exactly 0
+  template <typename URNG>
+  static double uniform(URNG& urng);
+
+  uint32_t layerBits_;       // cached random bits for the layer indices
+  int nLayerBits_;           // number of unused cached layer bits
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+template <typename URNG>
+inline uint32_t UniformBits<URNG>::next32(URNG& urng)
+{
+  constexpr int bits = bitsPerCall();
+  if (bits >= 32)
+    return static_cast<uint32_t>(static_cast<unsigned long long>(urng() - URNG::min()) & 0xFFFFFFFFULL);
+  uint64_t word = 0;
+  int nbits = 0;
+  while (nbits < 32) {
+    uint64_t draw = static_cast<uint64_t>(urng() - URNG::min()) & ((uint64_t(1) << bits) - 1);
+    word |= draw << nbits;
+    nbits += bits;
+  }
+  return static_cast<uint32_t>(word);
+}
+
+inline ZigguratNormal::Tables::Tables()
+{
+  double const R = 3.442619855899;           // start of the tail
+  double const V = 9.91256303526217e-3;      // area of each layer
+  double f = std::exp(-0.5 * R * R);
+  x[0] = V / f;
+  x[1] = R;
+  x[NLAYERS] = 0.0;
+  for (int i = 2; i < NLAYERS; ++i) {
+    x[i] = std::sqrt(-2.0 * std::log(V / x[i - 1] + f));
+    f = std::exp(-0.5 * x[i] * x[i]);
+  }
+  for (int i = 0; i < NLAYERS; ++i)
+    r[i] = x[i + 1] / x[i];
+}
+
+inline ZigguratNormal::Tables const& ZigguratNormal::tables()
+{
+  static Tables const tabs;
+  return tabs;
+}
+
+inline ZigguratNormal::ZigguratNormal()
+: layerBits_(0), nLayerBits_(0)
+{
+  tables();       // make sure the tables are initialized
+}
+
+inline void ZigguratNormal::reset()
+{
+  layerBits_ = 0;
+  nLayerBits_ = 0;
+}
+
+template <typename URNG>
+inline double ZigguratNormal::uniform(URNG& urng)
+{
+  // 32 bits centered in (0, 1)
+  return (UniformBits<URNG>::next32(urng) + 0.5) * (1.0 / 4294967296.0);
+}
+
+template <typename URNG>
+inline unsigned ZigguratNormal::nextLayer(URNG& urng)
+{
+  if (nLayerBits_ < 7) {
+    layerBits_ = UniformBits<URNG>::next32(urng);
+    nLayerBits_ = 28;            // 4 indices of 7 bits from each word
+  }
+  unsigned i = layerBits_ & 0x7F;
+  layerBits_ >>= 7;
+  nLayerBits_ -= 7;
+  return i;
+}
+
+template <typename URNG>
+inline double ZigguratNormal::operator()(URNG& urng)
+{
+  Tables const& tabs = tables();
+  double u = 2.0 * uniform(urng) - 1.0;
+  unsigned i = nextLayer(urng);
+  // the rectangular part of the layer, the fast path
+  if (std::fabs(u) < tabs.r[i])
+    return u * tabs.x[i];
+  return slowPath(urng, i, u);
+}
+
+template <typename URNG, typename ITER>
+inline void ZigguratNormal::generate(URNG& urng, ITER begin, ITER end)
+{
+  Tables const& tabs = tables();
+  for (ITER it = begin; it != end; ++it) {
+    double u = 2.0 * uniform(urng) - 1.0;
+    unsigned i = nextLayer(urng);
+    *it = std::fabs(u) < tabs.r[i] ? u * tabs.x[i] : slowPath(urng, i, u);
+  }
+}
+
+template <typename URNG>
+inline double ZigguratNormal::slowPath(URNG& urng, unsigned i, double u)
+{
+  Tables const& tabs = tables();
+  double const R = tabs.x[1];
+  for (;;) {
+    if (i == 0) {
+      // the base layer: sample from the tail beyond R
+      double x, y;
+      do {
+        x = std::log(uniform(urng)) / R;
+        y = std::log(uniform(urng));
+      } while (-2.0 * y < x * x);
+      return u < 0.0 ? x - R : R - x;
+    }
+    // the wedge between the rectangle and the curve
+    double x = u * tabs.x[i];
+    double f0 = std::exp(-0.5 * (tabs.x[i] * tabs.x[i] - x * x));
+    double f1 = std::exp(-0.5 * (tabs.x[i + 1] * tabs.x[i + 1] - x * x));
+    if (f1 + uniform(urng) * (f0 - f1) < 1.0)
+      return x;
+
+    // rejected, start over
+    u = 2.0 * uniform(urng) - 1.0;
+    i = nextLayer(urng);
+    if (std::fabs(u) < tabs.r[i])
+      return u * tabs.x[i];
+  }
+}
+
+END_NAMESPACE(orf)
+
+#endif // ORF_ZIGGURAT_HPP
@@ -40,7 +40,7 @@ protected:
 
 template <typename ITER>
 MeanVarCalculator<ITER>::MeanVarCalculator(size_t nvars)
-  : StatisticsCalculator(nvars, 2), runningSum_(nvars), runningSum2_(nvars)
+  : StatisticsCalculator<ITER>(nvars, 2), runningSum_(nvars), runningSum2_(nvars)
 {
   for (size_t j = 0; j < nvars; ++j) {
     runningSum2_(j) = runningSum_(j) = 0.0;
@@ -50,36 +50,36 @@ MeanVarCalculator<ITER>::MeanVarCalculator(size_t nvars)
 template <typename ITER>
 void MeanVarCalculator<ITER>::addSample(ITER begin, ITER end)
 {
-  ORF_ASSERT(end - begin == nVariables(), "missing variable values!");
+  ORF_ASSERT(end - begin == this->nVariables(), "missing variable values!");
 
   ITER it = begin;
-  for (size_t j = 0; j < nVariables(); ++j, ++it) {
+  for (size_t j = 0; j < this->nVariables(); ++j, ++it) {
     runningSum_(j) += *it;
     runningSum2_(j) += (*it) * (*it);
   }
 
-  ++nsamples_;
+  ++this->nsamples_;
 }
 
 template <typename ITER>
 Matrix const & MeanVarCalculator<ITER>::results()
 {
-  for (size_t j = 0; j < nVariables(); ++j) {
-    results_(0, j) = runningSum_(j) / nsamples_;
-    double mean = results_(0, j);
-    results_(1, j) = runningSum2_(j) / nsamples_ - mean * mean;
-    results_(1, j) *= nsamples_;
-    results_(1, j) /= (nsamples_ - 1);
+  for (size_t j = 0; j < this->nVariables(); ++j) {
+    this->results_(0, j) = runningSum_(j) / this->nsamples_;
+    double mean = this->results_(0, j);
+    this->results_(1, j) = runningSum2_(j) / this->nsamples_ - mean * mean;
+    this->results_(1, j) *= this->nsamples_;
+    this->results_(1, j) /= (this->nsamples_ - 1);
   }
 
-  return results_;
+  return this->results_;
 }
 
 template <typename ITER>
 void MeanVarCalculator<ITER>::reset()
 {
-  StatisticsCalculator::reset();
-  for (size_t j = 0; j < nVariables(); ++j) {
+  StatisticsCalculator<ITER>::reset();
+  for (size_t j = 0; j < this->nVariables(); ++j) {
     runningSum_(j) = 0.0;
     runningSum2_(j) = 0.0;
   }
@@ -13,7 +13,11 @@
 
 BEGIN_NAMESPACE(orf)
 
-/** Creates standard normal increments populating the time line sequentially.
+/** Creates standard normal increments with the Brownian bridge construction.
+    The full path is built by bisection: the terminal point first, then the midpoints.
+    Step by step generation (beginPath/nextStep) uses the forward ordered variant:
+    the terminal point is drawn first and then each point conditionally on the previous one
+    and the terminal point, W(t_i) | W(t_i-1), W(T). Both constructions have the same law.
     It is templetized on the underlying normal deviate generator.
 */
 template <typename NRNG>
@@ -54,6 +58,15 @@ public:
   /** Returns the next price path */
   virtual void next(Matrix& pricePath) override;
 
+  /** Returns the next price path in single precision */
+  virtual void next(FMatrix& pricePath) override;
+
+  /** Starts a new path to be generated step by step, drawing the terminal points */
+  virtual void beginPath(Matrix& pricePath) override;
+
+  /** Fills row i of the path with the correlated increments, using the forward bridge */
+  virtual void nextStep(size_t i, Matrix& pricePath) override;
+
 protected:
 
   // helper method for creating the list of bridge points
@@ -63,13 +76,26 @@ protected:
     int priority = 1);
 
   // helper method that creates the actual path
-  void createPath(double sqrtLastTime, Vector const& normalDevs, Matrix& path, size_t factorIdx);
+  template <typename MAT>
+  void createPath(double sqrtLastTime, Vector const& normalDevs, MAT& path, size_t factorIdx);
+
+  // fills the path with correlated normal deviates, in the precision of MAT
+  template <typename MAT>
+  void fillPath(MAT& pricePath, MAT const& sqrtCorrel);
 
   // state
   NRNG nrng_;
   std::list<BridgePoint> bridgePoints_;    // the list of bridge points sorted by priority
   double sqrtLastTime_;                    // the square root of the last time step
+  Vector sqrtDeltaT_;                      // sqrt(T1), sqrt(T2-T1), ...
   Vector normalDevs_;                      // scratch array
+
+  // state of the forward ordered bridge
+  Vector times_;                           // T1, T2, ...
+  Vector terminalW_;                       // the terminal point, one per factor
+  Vector prevW_;                           // the previous point, one per factor
+  Vector stepDevs_;                        // scratch array for one time step, one deviate per factor
+  Matrix fwdDevs_;                         // low discrepancy deviates, drawn in full by beginPath()
 };
 
 
@@ -92,6 +118,14 @@ inline BrownianBridge<NRNG>::BrownianBridge(ITER timestepsBegin,
   initBridgePoints(timePoints.begin(), timePoints.end(), timePoints.begin(), timePoints.end() - 1);
   bridgePoints_.sort();
   normalDevs_.resize(timestepsEnd - timestepsBegin);
+  sqrtDeltaT_.resize(ntimesteps_);
+  for (size_t i = 0; i < ntimesteps_; ++i)
+    sqrtDeltaT_[i] = sqrt(timePoints[i + 1] - timePoints[i]);
+  times_.resize(ntimesteps_);
+  std::copy(timestepsBegin, timestepsEnd, times_.begin());
+  terminalW_.resize(nfactors_);
+  prevW_.resize(nfactors_);
+  stepDevs_.resize(nfactors_);
 }
 
 template <typename NRNG>
@@ -161,28 +195,31 @@ BrownianBridge<NRNG>::initBridgePoints(ITER timestepsBegin,
 
 
 template <typename NRNG>
+template <typename MAT>
 inline void
 BrownianBridge<NRNG>::createPath(double sqrtLastTime,
                                  Vector const& normalDevs,
-                                 Matrix& path,
+                                 MAT& path,
                                  size_t factorIdx)
 {
+  using elem_type = typename MAT::elem_type;
   ORF_ASSERT(path.n_rows== normalDevs.size() + 1,
     "the path must have one more row than the number of normal deviates!");
 
-  path(0, factorIdx) = 0.0;
+  path(0, factorIdx) = 0;
   // generate last point
   int it2 = 0;
-  path(path.n_rows - 1, factorIdx) = normalDevs[it2];
+  path(path.n_rows - 1, factorIdx) = static_cast<elem_type>(sqrtLastTime * normalDevs[it2]);
   it2++;
   for (auto it = bridgePoints_.begin(); it != bridgePoints_.end(); ++it, ++it2) {
     ptrdiff_t i1 = it->first_point;
     ptrdiff_t i2 = it->second_point;
     ptrdiff_t i = it->middle_point;
-    double w1 = it->first_weight;
-    double w2 = it->second_weight;
-    double v = it->volatility;
-    path(i, factorIdx) = w1 * path(i1, factorIdx) + w2 * path(i2, factorIdx) + v * normalDevs[it2];
+    elem_type w1 = static_cast<elem_type>(it->first_weight);
+    elem_type w2 = static_cast<elem_type>(it->second_weight);
+    elem_type v = static_cast<elem_type>(it->volatility);
+    path(i, factorIdx) = w1 * path(i1, factorIdx) + w2 * path(i2, factorIdx)
+                       + v * static_cast<elem_type>(normalDevs[it2]);
   }
   return;
 }
@@ -190,31 +227,95 @@ BrownianBridge<NRNG>::createPath(double sqrtLastTime,
 template <typename NRNG>
 inline void BrownianBridge<NRNG>::next(Matrix& pricePath)
 {
-  pricePath.resize(ntimesteps_ + 1, nfactors_);
+  fillPath(pricePath, sqrtCorrel_);
+}
+
+template <typename NRNG>
+inline void BrownianBridge<NRNG>::next(FMatrix& pricePath)
+{
+  fillPath(pricePath, fsqrtCorrel_);
+}
+
+template <typename NRNG>
+inline void BrownianBridge<NRNG>::beginPath(Matrix& pricePath)
+{
+  pricePath.set_size(ntimesteps_, nfactors_);
+  if (IsLowDiscrepancy<NRNG>::value) {
+    // draw the full point; the first dimension of each factor goes to the terminal point
+    fwdDevs_.set_size(ntimesteps_, nfactors_);
+    for (size_t j = 0; j < nfactors_; ++j) {
+      nrng_.next(normalDevs_.begin(), normalDevs_.end());
+      for (size_t i = 0; i < ntimesteps_; ++i)
+        fwdDevs_(i, j) = normalDevs_(i);
+    }
+    for (size_t j = 0; j < nfactors_; ++j)
+      terminalW_(j) = sqrtLastTime_ * fwdDevs_(0, j);
+  }
+  else {
+    nrng_.next(stepDevs_.begin(), stepDevs_.end());
+    for (size_t j = 0; j < nfactors_; ++j)
+      terminalW_(j) = sqrtLastTime_ * stepDevs_(j);
+  }
+  prevW_.zeros();
+}
+
+template <typename NRNG>
+inline void BrownianBridge<NRNG>::nextStep(size_t i, Matrix& pricePath)
+{
+  double tprev = i > 0 ? times_(i - 1) : 0.0;
+  double dt = times_(i) - tprev;
+  bool last = (i + 1 == ntimesteps_);
+  if (!last) {
+    if (IsLowDiscrepancy<NRNG>::value) {
+      for (size_t j = 0; j < nfactors_; ++j)
+        stepDevs_(j) = fwdDevs_(i + 1, j);
+    }
+    else
+      nrng_.next(stepDevs_.begin(), stepDevs_.end());
+  }
+
+  for (size_t j = 0; j < nfactors_; ++j) {
+    double w;
+    if (last)
+      w = terminalW_(j);
+    else if (dt > 0.0) {
+      // conditional on the previous and the terminal point
+      double remaining = times_(ntimesteps_ - 1) - tprev;
+      double mean = prevW_(j) + dt / remaining * (terminalW_(j) - prevW_(j));
+      double stdev = sqrt(dt * (times_(ntimesteps_ - 1) - times_(i)) / remaining);
+      w = mean + stdev * stepDevs_(j);
+    }
+    else
+      w = prevW_(j);
+    pricePath(i, j) = dt > 0.0 ? (w - prevW_(j)) / sqrtDeltaT_(i) : 0.0;
+    prevW_(j) = w;
+  }
+  correlateRow(pricePath, i, sqrtCorrel_);
+}
+
+template <typename NRNG>
+template <typename MAT>
+inline void BrownianBridge<NRNG>::fillPath(MAT& pricePath, MAT const& sqrtCorrel)
+{
+  using elem_type = typename MAT::elem_type;
+  pricePath.set_size(ntimesteps_ + 1, nfactors_);
 
   for (size_t j = 0; j < nfactors_; ++j) {
     nrng_.next(normalDevs_.begin(), normalDevs_.end());
     createPath(sqrtLastTime_, normalDevs_, pricePath, j);
   }
-  // now compute the increments
+  // now compute the increments, scaled to unit variance per time step
+  // (a zero length step, e.g. a fixing at t = 0, has a zero increment)
   for (size_t j = 0; j < nfactors_; ++j)
     for (size_t i = 0; i < ntimesteps_; ++i)
-      pricePath(i, j) = pricePath(i + 1, j) - pricePath(i, j);
-  // remove the top row
+      pricePath(i, j) = sqrtDeltaT_[i] > 0.0
+                      ? (pricePath(i + 1, j) - pricePath(i, j)) / static_cast<elem_type>(sqrtDeltaT_[i])
+                      : 0;
+  // remove the last row
   pricePath.resize(ntimesteps_, nfactors_);
 
   // finally apply the Cholesky factor if not empty
-  if (sqrtCorrel_.n_rows != 0) {
-    for (size_t i = 0; i < ntimesteps_; ++i) {
-      for (size_t j = 0; j < nfactors_; ++j) {
-        double sum = 0.0;
-        for (size_t k = 0; k < nfactors_; ++k) {
-          sum += sqrtCorrel_(nfactors_ - j - 1, k) * pricePath(i, k);
-        }
-        pricePath(i, nfactors_ - j - 1) = sum;
-      }
-    }
-  }
+  correlate(pricePath, sqrtCorrel);
 }
 
 END_NAMESPACE(orf)
@@ -32,10 +32,26 @@ public:
   /** Returns the next price path */
   virtual void next(Matrix& pricePath) override;
 
+  /** Returns the next price path in single precision */
+  virtual void next(FMatrix& pricePath) override;
+
+  /** Starts a new path to be generated step by step.
+      Low discrepancy generators produce the whole path here.
+  */
+  virtual void beginPath(Matrix& pricePath) override;
+
+  /** Fills row i of the path with correlated normal deviates */
+  virtual void nextStep(size_t i, Matrix& pricePath) override;
+
 protected:
+  // fills the path with correlated normal deviates, in the precision of MAT
+  template <typename MAT>
+  void fillPath(MAT& pricePath, MAT const& sqrtCorrel);
+
   NRNG nrng_;
   Vector sqrtDeltaT_;              // sqrt(T1), sqrt(T2-T1), ...
   Vector normalDevs_;              // scratch array
+  Vector stepDevs_;                // scratch array for one time step, one deviate per factor
 
 };
 
@@ -53,6 +69,7 @@ inline EulerPathGenerator<NRNG>::EulerPathGenerator(ITER timestepsBegin,
 {
   ORF_ASSERT(ntimesteps_ > 0, "no time steps!");
   normalDevs_.resize(ntimesteps_);
+  stepDevs_.resize(nfactors_);
   sqrtDeltaT_.resize(ntimesteps_);
   sqrtDeltaT_[0] = sqrt(*timestepsBegin);
   ITER it = ++timestepsBegin;
@@ -73,25 +90,49 @@ inline size_t EulerPathGenerator<NRNG>::dim() const
 template <typename NRNG>
 inline void EulerPathGenerator<NRNG>::next(Matrix& pricePath)
 {
-  pricePath.resize(ntimesteps_, nfactors_);
+  fillPath(pricePath, sqrtCorrel_);
+}
+
+template <typename NRNG>
+inline void EulerPathGenerator<NRNG>::next(FMatrix& pricePath)
+{
+  fillPath(pricePath, fsqrtCorrel_);
+}
+
+template <typename NRNG>
+inline void EulerPathGenerator<NRNG>::beginPath(Matrix& pricePath)
+{
+  if (IsLowDiscrepancy<NRNG>::value)
+    fillPath(pricePath, sqrtCorrel_);    // the point must be drawn in full
+  else
+    pricePath.set_size(ntimesteps_, nfactors_);
+}
+
+template <typename NRNG>
+inline void EulerPathGenerator<NRNG>::nextStep(size_t i, Matrix& pricePath)
+{
+  if (IsLowDiscrepancy<NRNG>::value)
+    return;                              // already generated by beginPath()
+  nrng_.next(stepDevs_.begin(), stepDevs_.end());
+  for (size_t j = 0; j < nfactors_; ++j)
+    pricePath(i, j) = stepDevs_(j);
+  correlateRow(pricePath, i, sqrtCorrel_);
+}
+
+template <typename NRNG>
+template <typename MAT>
+inline void EulerPathGenerator<NRNG>::fillPath(MAT& pricePath, MAT const& sqrtCorrel)
+{
+  using elem_type = typename MAT::elem_type;
+  pricePath.set_size(ntimesteps_, nfactors_);
   // iterate over columns; the matrix will be filled column by column
   for (size_t j = 0; j < nfactors_; ++j) {
     nrng_.next(normalDevs_.begin(), normalDevs_.end());
     for (size_t i = 0; i < ntimesteps_; ++i)
-      pricePath(i, j) = normalDevs_(i);
+      pricePath(i, j) = static_cast<elem_type>(normalDevs_(i));
   }
   // finally apply the Cholesky factor if not empty
-  if (sqrtCorrel_.n_rows != 0) {
-    for (size_t i = 0; i < ntimesteps_; ++i) {
-      for (size_t j = 0; j < nfactors_; ++j) {
-        double sum = 0.0;
-        for (size_t k = 0; k < nfactors_; ++k) {
-          sum += sqrtCorrel_(nfactors_ - j - 1, k) * pricePath(i, k);
-        }
-        pricePath(i, nfactors_ - j - 1) = sum;
-      }
-    }
-  }
+  correlate(pricePath, sqrtCorrel);
 }
 
 END_NAMESPACE(orf)
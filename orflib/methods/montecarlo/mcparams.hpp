@@ -23,6 +23,7 @@ struct McParams
     MT19937,
     RANLUX3,
     RANLUX4,
+    XOSHIRO256,
     SOBOL
   };
 
@@ -30,24 +31,38 @@ struct McParams
   enum class PathGenType
   {
     EULER,
-    BROWNIANBRIDGE
+    BROWNIANBRIDGE,
+    PCA
+  };
+
+  /** The floating point precision of the simulated paths.
+      SINGLE generates normals, correlates them and converts them to prices in float,
+      while the product PVs and the statistics are still accumulated in double.
+  */
+  enum class PathPrecision
+  {
+    DOUBLE,
+    SINGLE
   };
 
 
   /** Default ctor */
-  McParams(UrngType u = UrngType::MT19937, PathGenType p = PathGenType::EULER);
+  McParams(UrngType u = UrngType::MT19937, PathGenType p = PathGenType::EULER,
+           PathPrecision pp = PathPrecision::DOUBLE, size_t rank = 0);
 
   // state
   UrngType urngType;
   PathGenType pathGenType;
+  PathPrecision pathPrecision;
+  size_t pcaRank;            // number of principal components for PCA paths, 0 for all
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 // Inline definitions
 
 inline
-McParams::McParams(UrngType u, PathGenType p)
-: urngType(u), pathGenType(p)
+McParams::McParams(UrngType u, PathGenType p, PathPrecision pp, size_t rank)
+: urngType(u), pathGenType(p), pathPrecision(pp), pcaRank(rank)
 {}
 
 END_NAMESPACE(orf)
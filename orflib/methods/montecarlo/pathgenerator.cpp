@@ -15,6 +15,7 @@ void PathGenerator::initCorrelation(Matrix const& corrMat)
   Matrix fixedCorrel = corrMat;
   spectrunc(fixedCorrel);               // spectral truncation
   choldcmp(fixedCorrel, sqrtCorrel_);   // Cholesky decomposition
+  fsqrtCorrel_ = arma::conv_to<FMatrix>::from(sqrtCorrel_);
 }
 
 END_NAMESPACE(orf)
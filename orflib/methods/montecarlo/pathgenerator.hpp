@@ -34,6 +34,25 @@ public:
   */
   virtual void next(Matrix& pricePath) = 0;
 
+  /** Returns the next price path in single precision.
+      The default implementation generates the path in double and converts it;
+      generators override it to run the whole pipeline in float.
+  */
+  virtual void next(FMatrix& pricePath);
+
+  /** Starts a new path, to be generated time step by time step with nextStep().
+      The Matrix is resized to size ntimesteps * nfactors.
+      The default implementation generates the whole path at once.
+  */
+  virtual void beginPath(Matrix& pricePath);
+
+  /** Fills row i of the path started by beginPath() with the deviates of time step i.
+      The steps must be requested in increasing order; the remaining steps of a path
+      can be skipped, e.g. when the product has been decided early.
+      The default implementation does nothing, since beginPath() filled the whole path.
+  */
+  virtual void nextStep(size_t i, Matrix& pricePath);
+
 protected:
   PathGenerator() {};     // default ctor
   PathGenerator(size_t ntimesteps, size_t nfactors, Matrix const& correlation);
@@ -41,9 +60,21 @@ protected:
   // Does spectral truncation and Cholesky decomposition on the correlation matrix
   void initCorrelation(Matrix const& correlation);
 
+  // Applies the Cholesky factor to the independent normals in each row of the path, in-place
+  template <typename MAT>
+  void correlate(MAT& path, MAT const& sqrtCorrel) const;
+
+  // Applies the Cholesky factor to the independent normals in row i of the path, in-place
+  template <typename MAT>
+  void correlateRow(MAT& path, size_t i, MAT const& sqrtCorrel) const;
+
   size_t ntimesteps_;    // the number of time steps
   size_t nfactors_;      // the number of factors
   Matrix sqrtCorrel_;    // the Cholesky factor of the correlation matrix
+  FMatrix fsqrtCorrel_;  // the Cholesky factor in single precision
+
+private:
+  Matrix pathScratch_;   // scratch path for the default single precision next()
 };
 
 using SPtrPathGenerator = std::shared_ptr<PathGenerator>;
@@ -71,6 +102,44 @@ inline size_t PathGenerator::nFactors() const
   return nfactors_;
 }
 
+inline void PathGenerator::next(FMatrix& pricePath)
+{
+  next(pathScratch_);
+  pricePath = arma::conv_to<FMatrix>::from(pathScratch_);
+}
+
+inline void PathGenerator::beginPath(Matrix& pricePath)
+{
+  next(pricePath);
+}
+
+inline void PathGenerator::nextStep(size_t, Matrix&)
+{}
+
+template <typename MAT>
+inline void PathGenerator::correlate(MAT& path, MAT const& sqrtCorrel) const
+{
+  if (sqrtCorrel.n_rows == 0)
+    return;
+  for (size_t i = 0; i < path.n_rows; ++i)
+    correlateRow(path, i, sqrtCorrel);
+}
+
+template <typename MAT>
+inline void PathGenerator::correlateRow(MAT& path, size_t i, MAT const& sqrtCorrel) const
+{
+  if (sqrtCorrel.n_rows == 0)
+    return;
+  // go backwards over the factors, so that the lower triangular factor can be applied in-place
+  for (size_t j = 0; j < nfactors_; ++j) {
+    typename MAT::elem_type sum = 0;
+    for (size_t k = 0; k < nfactors_; ++k) {
+      sum += sqrtCorrel(nfactors_ - j - 1, k) * path(i, k);
+    }
+    path(i, nfactors_ - j - 1) = sum;
+  }
+}
+
 END_NAMESPACE(orf)
 
 #endif // ORF_PATHGENERATOR_HPP
@@ -0,0 +1,168 @@
+/**
+@file  pcapathgenerator.hpp
+@brief Monte Carlo path generator based on the principal components of the path covariance
+*/
+
+#ifndef ORF_PCAPATHGENERATOR_HPP
+#define ORF_PCAPATHGENERATOR_HPP
+
+#include <orflib/methods/montecarlo/pathgenerator.hpp>
+#include <orflib/math/random/rng.hpp>
+#include <orflib/math/linalg/linalg.hpp>
+
+BEGIN_NAMESPACE(orf)
+
+/** Creates standard normal increments from the principal components of the joint
+    covariance of the Brownian motions across time steps and factors,
+    Cov(W_j(t_i), W_l(t_k)) = min(t_i, t_k) * rho_jl.
+    The components are ordered by decreasing variance, so that the first deviates
+    (e.g. the first Sobol dimensions) drive most of the variance of the path.
+    The loadings include the correlation, the differencing in time and the scaling
+    to unit variance per time step, and are applied to a block of paths at once
+    with a single matrix product.
+    It is templetized on the underlying normal deviate generator.
+*/
+template <typename NRNG>
+class PcaPathGenerator : public PathGenerator
+{
+public:
+
+  /** Ctor for generating increments for correlated factors.
+      If the correlation matrix is not passed in, it assumes independent factors.
+      If rank is zero or larger than ntimesteps * nfactors, all components are used,
+      otherwise only the rank components with the largest variance.
+  */
+  template<typename ITER>
+  PcaPathGenerator(ITER timestepsBegin, ITER timestepsEnd, size_t nfactors,
+                   Matrix const& correlMat = Matrix(), size_t rank = 0);
+
+  /** Returns the dimension of the generator, i.e. the number of components used */
+  size_t dim() const;
+
+  /** Returns the next price path */
+  virtual void next(Matrix& pricePath) override;
+
+  /** Returns the next price path in single precision */
+  virtual void next(FMatrix& pricePath) override;
+
+protected:
+  // generates the next block of paths
+  void nextBlock();
+
+  enum { BLOCKSIZE = 256 };        // number of paths generated with one matrix product
+
+  NRNG nrng_;
+  size_t rank_;                    // number of principal components used
+  Matrix loadings_;                // (ntimesteps * nfactors) x rank
+  Matrix devsBlock_;               // rank x BLOCKSIZE independent deviates
+  Matrix pathsBlock_;              // (ntimesteps * nfactors) x BLOCKSIZE increments, one path per column
+  size_t blockIdx_;                // the next unused path in pathsBlock_
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+template <typename NRNG>
+template <typename ITER>
+inline PcaPathGenerator<NRNG>::PcaPathGenerator(ITER timestepsBegin,
+                                                ITER timestepsEnd,
+                                                size_t nfactors,
+                                                Matrix const& correlMat,
+                                                size_t rank)
+  : PathGenerator((timestepsEnd - timestepsBegin), nfactors, correlMat),
+  nrng_((rank == 0 || rank > size_t(timestepsEnd - timestepsBegin) * nfactors)
+        ? (timestepsEnd - timestepsBegin) * nfactors : rank, 0.0, 1.0),
+  rank_(nrng_.dim()), blockIdx_(BLOCKSIZE)
+{
+  ORF_ASSERT(ntimesteps_ > 0, "no time steps!");
+  size_t ndim = ntimesteps_ * nfactors_;
+
+  Vector times(ntimesteps_);
+  std::copy(timestepsBegin, timestepsEnd, times.begin());
+  for (size_t i = 1; i < ntimesteps_; ++i)
+    ORF_ASSERT(times(i) > times(i - 1), "time steps are not unique or not in increasing order!");
+
+  // the factor correlation, after spectral truncation
+  Matrix correl(nfactors_, nfactors_, arma::fill::zeros);
+  if (sqrtCorrel_.n_rows != 0)
+    correl = sqrtCorrel_ * sqrtCorrel_.t();
+  else
+    for (size_t j = 0; j < nfactors_; ++j)
+      correl(j, j) = 1.0;
+
+  // joint covariance; index i + j * ntimesteps matches the column-wise path layout
+  Matrix cov(ndim, ndim);
+  for (size_t j = 0; j < nfactors_; ++j)
+    for (size_t i = 0; i < ntimesteps_; ++i)
+      for (size_t l = 0; l < nfactors_; ++l)
+        for (size_t k = 0; k < ntimesteps_; ++k)
+          cov(i + j * ntimesteps_, k + l * ntimesteps_) = std::min(times(i), times(k)) * correl(j, l);
+
+  Vector eigvals;
+  Matrix eigvecs;
+  eigensym(cov, eigvals, eigvecs);
+
+  // the eigenvalues come in ascending order; take the largest rank_ ones
+  loadings_.zeros(ndim, rank_);
+  for (size_t c = 0; c < rank_; ++c) {
+    size_t e = ndim - 1 - c;
+    double sqrtval = eigvals(e) > 0.0 ? sqrt(eigvals(e)) : 0.0;
+    for (size_t r = 0; r < ndim; ++r)
+      loadings_(r, c) = eigvecs(r, e) * sqrtval;
+  }
+
+  // turn the Brownian motion loadings into loadings of the unit variance increments
+  for (size_t j = 0; j < nfactors_; ++j) {
+    for (size_t i = ntimesteps_; i-- > 0;) {
+      double dt = times(i) - (i > 0 ? times(i - 1) : 0.0);
+      size_t r = i + j * ntimesteps_;
+      for (size_t c = 0; c < rank_; ++c) {
+        double prev = i > 0 ? loadings_(r - 1, c) : 0.0;
+        loadings_(r, c) = dt > 0.0 ? (loadings_(r, c) - prev) / sqrt(dt) : 0.0;
+      }
+    }
+  }
+
+  devsBlock_.set_size(rank_, BLOCKSIZE);
+}
+
+template <typename NRNG>
+inline size_t PcaPathGenerator<NRNG>::dim() const
+{
+  return nrng_.dim();
+}
+
+template <typename NRNG>
+inline void PcaPathGenerator<NRNG>::nextBlock()
+{
+  for (size_t k = 0; k < BLOCKSIZE; ++k)
+    nrng_.next(devsBlock_.colptr(k), devsBlock_.colptr(k) + rank_);
+  pathsBlock_ = loadings_ * devsBlock_;
+  blockIdx_ = 0;
+}
+
+template <typename NRNG>
+inline void PcaPathGenerator<NRNG>::next(Matrix& pricePath)
+{
+  if (blockIdx_ == BLOCKSIZE)
+    nextBlock();
+  pricePath.set_size(ntimesteps_, nfactors_);
+  double const* src = pathsBlock_.colptr(blockIdx_++);
+  std::copy(src, src + pricePath.n_elem, pricePath.memptr());
+}
+
+template <typename NRNG>
+inline void PcaPathGenerator<NRNG>::next(FMatrix& pricePath)
+{
+  if (blockIdx_ == BLOCKSIZE)
+    nextBlock();
+  pricePath.set_size(ntimesteps_, nfactors_);
+  double const* src = pathsBlock_.colptr(blockIdx_++);
+  float* dst = pricePath.memptr();
+  for (size_t i = 0; i < pricePath.n_elem; ++i)
+    dst[i] = static_cast<float>(src[i]);
+}
+
+END_NAMESPACE(orf)
+
+#endif // ORF_PCAPATHGENERATOR_HPP
@@ -0,0 +1,183 @@
+/**
+@file  pde1dforwardsolver.cpp
+@brief Implementation of the 1-dim forward (Dupire) PDE solver
+*/
+
+#include <orflib/methods/pde/pde1dforwardsolver.hpp>
+#include <orflib/math/interpol/interpolation1d.hpp>
+#include <algorithm>
+#include <cmath>
+
+BEGIN_NAMESPACE(orf)
+
+void Pde1DForwardSolver::solve(PdeParams const& params, Vector const& maturities, Vector const& strikes)
+{
+  ORF_ASSERT(params.nSpotNodes.size() == 1, "Pde1DForwardSolver: the pde parameters must have one axis!");
+  ORF_ASSERT(maturities.size() > 0 && strikes.size() > 0, "Pde1DForwardSolver: no maturities or strikes!");
+  ORF_ASSERT(params.scheme == PdeParams::Scheme::THETA || params.scheme == PdeParams::Scheme::RANNACHER,
+    "Pde1DForwardSolver: only the THETA and RANNACHER schemes are supported!");
+  ORF_ASSERT(params.timeStepTolerance == 0.0, "Pde1DForwardSolver: only fixed time steps are supported!");
+  ORF_ASSERT(params.spatialScheme == PdeParams::SpatialScheme::CENTRAL,
+    "Pde1DForwardSolver: only the central differences are supported!");
+  ORF_ASSERT(maturities[0] > 0.0, "Pde1DForwardSolver: the maturities must be positive!");
+  for (size_t m = 1; m < maturities.size(); ++m)
+    ORF_ASSERT(maturities[m] > maturities[m - 1], "Pde1DForwardSolver: the maturities must be increasing!");
+  for (size_t k = 0; k < strikes.size(); ++k)
+    ORF_ASSERT(strikes[k] > 0.0, "Pde1DForwardSolver: the strikes must be positive!");
+
+  setTimeSteps(maturities, params.nTimeSteps);
+  initGrid(params, maturities[maturities.size() - 1], strikes);
+
+  // the calls expiring now are worth their payoff
+  size_t n = grid_.NX + 2;
+  values_.set_size(n, 1);
+  rhs_.set_size(n, 1);
+  for (size_t i = 0; i < n; ++i)
+    values_(i, 0) = std::max(spot_ - grid_.Slevels[i], 0.0);
+
+  results_.maturities = maturities;
+  results_.strikes = strikes;
+  results_.callPrices.set_size(maturities.size(), strikes.size());
+  results_.gridValues.set_size(n, maturities.size());
+  results_.times.resize(timesteps_.size());
+  std::copy(timesteps_.begin(), timesteps_.end(), results_.times.begin());
+
+  size_t m = 0;   // the next maturity
+  for (size_t step = 0; step + 1 < timesteps_.size(); ++step) {
+    double T1 = timesteps_[step], T2 = timesteps_[step + 1];
+    if (params.scheme == PdeParams::Scheme::RANNACHER && step < params.nSmoothingSteps) {
+      // damp the payoff kink with two implicit half steps
+      thetaStep(T1, 0.5 * (T1 + T2), 1.0);
+      thetaStep(0.5 * (T1 + T2), T2, 1.0);
+    }
+    else
+      thetaStep(T1, T2, params.scheme == PdeParams::Scheme::RANNACHER ? 0.5 : params.theta);
+
+    if (grid_.isUniform())
+      applyBoundaryConditions(values_);
+    else
+      applyBoundaryConditions(values_, grid_.spacings);
+    // the dividends
+    values_ *= std::exp(-divyield_ * (T2 - T1));
+
+    while (m < maturities.size() && maturitySteps_[m] == step + 1)
+      storeMaturity(m++, strikes);
+  }
+
+  results_.gridAxes.assign(1, grid_);
+  results_.nTimeSteps = timesteps_.size() - 1;
+}
+
+void Pde1DForwardSolver::setTimeSteps(Vector const& maturities, size_t nsteps)
+{
+  double maxdt = maturities[maturities.size() - 1] / std::max(nsteps, size_t(1));
+  timesteps_.assign(1, 0.0);
+  maturitySteps_.resize(maturities.size());
+  for (size_t m = 0; m < maturities.size(); ++m) {
+    double T1 = timesteps_.back();
+    size_t n = std::max(size_t(1), size_t(std::ceil((maturities[m] - T1) / maxdt - 1.0e-8)));
+    for (size_t j = 1; j < n; ++j)
+      timesteps_.push_back(T1 + j * (maturities[m] - T1) / n);
+    timesteps_.push_back(maturities[m]);
+    maturitySteps_[m] = timesteps_.size() - 1;
+  }
+}
+
+void Pde1DForwardSolver::initGrid(PdeParams const& params, double T, Vector const& strikes)
+{
+  GridAxis& grax = grid_;
+  grax.NX = params.nSpotNodes[0];
+
+  // the bounds around the forward to the last maturity, as for a spot axis
+  double rate = spdiscyc_->spotRate(T);
+  double forward = spot_ * std::exp((rate - divyield_) * T);
+  double vol = vol_ ? vol_->spotVol(T) : localVol_(0.5 * T, spot_);
+  grax.coordinateChange->init(params);
+  double X0 = grax.coordinateChange->fromRealToDiffused(spot_);
+  double forwardX = forward;
+  double volX = vol;
+  grax.coordinateChange->forwardAndVariance(forwardX, volX, T);
+  grax.coordinateChange->bounds(X0, forwardX, volX, T, params.nStdDevs[0], grax.Xmin, grax.Xmax);
+  // widen them to cover the strikes
+  double margin = 0.05 * (grax.Xmax - grax.Xmin);
+  for (size_t k = 0; k < strikes.size(); ++k) {
+    double Xk = grax.coordinateChange->fromRealToDiffused(strikes[k]);
+    grax.Xmin = std::min(grax.Xmin, Xk - margin);
+    grax.Xmax = std::max(grax.Xmax, Xk + margin);
+  }
+  grax.DX = (grax.Xmax - grax.Xmin) / (grax.NX + 1);
+
+  // a node on the spot, where the initial payoff has its kink
+  double concentration = params.nodeConcentration.empty() ? 0.0 : params.nodeConcentration[0];
+  if (concentration > 0.0) {
+    grax.concentrateNodes({ X0 }, (grax.Xmax - grax.Xmin) / concentration, X0);
+  }
+  else {
+    int X0NodeIdx = int(0.5 + (X0 - grax.Xmin) / grax.DX);
+    double closestX = grax.Xmin + X0NodeIdx * grax.DX;
+    grax.Xmin -= closestX - X0;
+    grax.Xmax -= closestX - X0;
+    grax.spacings.reset();
+    grax.Xlevels.resize(grax.NX + 2);
+    for (size_t j = 0; j <= grax.NX + 1; ++j)
+      grax.Xlevels[j] = grax.Xmin + j * grax.DX;
+  }
+
+  grax.Slevels.resize(grax.NX + 2);
+  for (size_t j = 0; j <= grax.NX + 1; ++j)
+    grax.Slevels[j] = grax.coordinateChange->fromDiffusedToReal(grax.Xlevels[j]);
+  grax.initFactors();
+  nodeVols_.set_size(grax.NX);
+}
+
+void Pde1DForwardSolver::thetaStep(double T1, double T2, double theta)
+{
+  GridAxis& grax = grid_;
+  double DT = T2 - T1;
+  // the calls deep in the money are worth S e^{-qT} - K e^{-rT}; their strike part grows by this factor,
+  // before the dividends
+  double aCoeff = std::exp(-(spdiscyc_->fwdRate(T1, T2) - divyield_) * DT);
+  if (vol_)
+    grax.setCoefficients(DT, aCoeff, theta, vol_->fwdVol(T1, T2));
+  else {
+    for (size_t j = 1; j <= grax.NX; ++j)
+      nodeVols_[j - 1] = localVol_(T1 + 0.5 * DT, grax.Slevels[j]);
+    grax.setCoefficients(DT, aCoeff, theta, nodeVols_);
+  }
+
+  if (grax.isUniform()) {
+    opImplicit_.initConvectionDiffusion(grax.drifts, grax.variances, DT, grax.DX, -theta);
+    adjustOpForBoundaryConditions(opImplicit_, grax.DX);
+  }
+  else {
+    opImplicit_.initConvectionDiffusion(grax.drifts, grax.variances, DT, grax.spacings, -theta);
+    adjustOpForBoundaryConditions(opImplicit_, grax.spacings);
+  }
+  if (theta < 1.0) {
+    if (grax.isUniform()) {
+      opExplicit_.initConvectionDiffusion(grax.drifts, grax.variances, DT, grax.DX, 1.0 - theta);
+      adjustOpForBoundaryConditions(opExplicit_, grax.DX);
+    }
+    else {
+      opExplicit_.initConvectionDiffusion(grax.drifts, grax.variances, DT, grax.spacings, 1.0 - theta);
+      adjustOpForBoundaryConditions(opExplicit_, grax.spacings);
+    }
+    opExplicit_.applyToLayers(values_, rhs_);
+    opImplicit_.applyInverseToLayers(rhs_, values_);
+  }
+  else {
+    opImplicit_.applyInverseToLayers(values_, rhs_);
+    std::swap(values_, rhs_);
+  }
+}
+
+void Pde1DForwardSolver::storeMaturity(size_t m, Vector const& strikes)
+{
+  results_.gridValues.col(m) = values_.col(0);
+  ArrayView prices(values_.colptr(0), values_.n_rows);
+  CubicSplineInterpolation1D<ArrayView> interp(grid_.Xlevels, prices);
+  for (size_t k = 0; k < strikes.size(); ++k)
+    results_.callPrices(m, k) = interp.getValue(grid_.coordinateChange->fromRealToDiffused(strikes[k]));
+}
+
+END_NAMESPACE(orf)
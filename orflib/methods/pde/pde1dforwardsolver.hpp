@@ -0,0 +1,100 @@
+/**
+@file  pde1dforwardsolver.hpp
+@brief Definition of the 1-dim forward (Dupire) PDE solver for European call prices
+*/
+
+#ifndef ORF_PDE1DFORWARDSOLVER_HPP
+#define ORF_PDE1DFORWARDSOLVER_HPP
+
+#include <orflib/market/yieldcurve.hpp>
+#include <orflib/market/volatilitytermstructure.hpp>
+#include <orflib/methods/pde/pdeparams.hpp>
+#include <orflib/methods/pde/pdegrid.hpp>
+#include <orflib/methods/pde/pderesults.hpp>
+#include <orflib/methods/pde/tridiagonalops1d.hpp>
+#include <functional>
+
+BEGIN_NAMESPACE(orf)
+
+/** The forward pde solver for the prices of European calls on one asset, for all strikes and
+    maturities at once. It solves the Dupire equation
+      dC/dT = 1/2 sigma^2(T, K) K^2 d2C/dK2 - (r - q) K dC/dK - q C,   C(0, K) = (S0 - K)^+
+    forward in the maturity T, on a grid of log-strikes set up like the spot axis of the backward solvers,
+    and reads the prices at each maturity off the grid by cubic spline interpolation.
+    The volatility is either a term structure, or a local volatility function of time and strike.
+    The drifts are calibrated through the coordinate change, so that the prices of the deep in the money
+    calls, which are linear in the strike, are exact.
+    The time stepping is the THETA or the RANNACHER scheme of the PdeParams, with fixed time steps.
+*/
+class Pde1DForwardSolver
+{
+public:
+  /** The local volatility as a function of the time and the strike */
+  using LocalVolFunction = std::function<double(double, double)>;
+
+  /** Ctor from the market data, with a term structure of volatilities.
+      The results are written to the passed-in object.
+  */
+  Pde1DForwardSolver(double spot,
+                     SPtrYieldCurve discountYieldCurve,
+                     double divyield,
+                     SPtrVolatilityTermStructure vol,
+                     Pde1DForwardResults& results)
+  : spot_(spot), spdiscyc_(discountYieldCurve), divyield_(divyield), vol_(vol), results_(results)
+  {
+    ORF_ASSERT(spot > 0.0, "Pde1DForwardSolver: the spot must be positive!");
+    ORF_ASSERT(vol, "Pde1DForwardSolver: missing volatility!");
+  }
+
+  /** Ctor from the market data, with a local volatility function.
+      The grid is sized with the local volatility at the spot and half the last maturity.
+  */
+  Pde1DForwardSolver(double spot,
+                     SPtrYieldCurve discountYieldCurve,
+                     double divyield,
+                     LocalVolFunction localVol,
+                     Pde1DForwardResults& results)
+  : spot_(spot), spdiscyc_(discountYieldCurve), divyield_(divyield), localVol_(localVol), results_(results)
+  {
+    ORF_ASSERT(spot > 0.0, "Pde1DForwardSolver: the spot must be positive!");
+    ORF_ASSERT(localVol_, "Pde1DForwardSolver: missing local volatility!");
+  }
+
+  /** Solves forward to the last of the increasing maturities and stores the call prices
+      at each maturity and strike in the results. Each maturity is a time step.
+  */
+  void solve(PdeParams const& params, Vector const& maturities, Vector const& strikes);
+
+protected:
+
+  /** Sets up the time steps from 0 to the last maturity, through each maturity */
+  void setTimeSteps(Vector const& maturities, size_t nsteps);
+
+  /** Sets up the log-strike axis to the last maturity T, wide enough for the strikes */
+  void initGrid(PdeParams const& params, double T, Vector const& strikes);
+
+  /** One step of the theta scheme from T1 to T2, (I - theta DT L) C(T2) = (I + (1 - theta) DT L) C(T1) */
+  void thetaStep(double T1, double T2, double theta);
+
+  /** Stores the prices at the maturity with index m */
+  void storeMaturity(size_t m, Vector const& strikes);
+
+  // state
+  double spot_;
+  SPtrYieldCurve spdiscyc_;
+  double divyield_;
+  SPtrVolatilityTermStructure vol_;
+  LocalVolFunction localVol_;
+  Pde1DForwardResults& results_;
+
+  GridAxis grid_;                     // the log-strike axis
+  std::vector<double> timesteps_;
+  std::vector<size_t> maturitySteps_; // the time step index of each maturity
+  Matrix values_, rhs_;               // the call prices at the strike nodes, and the right-hand side
+  Vector nodeVols_;                   // the local volatilities at the interior strike nodes
+  TridiagonalOp1D<Vector> opExplicit_, opImplicit_;
+};
+
+END_NAMESPACE(orf)
+
+#endif  // #ifndef ORF_PDE1DFORWARDSOLVER_HPP
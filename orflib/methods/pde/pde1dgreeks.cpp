@@ -0,0 +1,25 @@
+/**
+@file  pde1dgreeks.cpp
+@brief Implementation of the vega of 1-dim PDE prices
+*/
+
+#include <orflib/methods/pde/pde1dgreeks.hpp>
+
+BEGIN_NAMESPACE(orf)
+
+double solvePde1DVega(Pde1DJob const& job, Pde1DResults const& baseResults, double volBump)
+{
+  ORF_ASSERT(job.product, "solvePde1DVega: missing product!");
+  ORF_ASSERT(volBump != 0.0, "solvePde1DVega: the volatility bump must not be zero!");
+  ORF_ASSERT(!baseResults.gridAxes.empty() && baseResults.prices.size() == 1,
+    "solvePde1DVega: the base results are not those of a solved job!");
+
+  SPtrVolatilityTermStructure bumpedVol(new VolatilityTermStructure(job.vol->shifted(volBump)));
+  Pde1DResults bumped;
+  Pde1DSolver solver(job.product->clone(), job.discountCurve, job.spot, job.divYield, bumpedVol, bumped);
+  solver.setGridAxes(baseResults.gridAxes);
+  solver.solve(job.params);
+  return (bumped.prices[0] - baseResults.prices[0]) / volBump;
+}
+
+END_NAMESPACE(orf)
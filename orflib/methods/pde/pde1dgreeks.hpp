@@ -0,0 +1,23 @@
+/**
+@file  pde1dgreeks.hpp
+@brief The vega of 1-dim PDE prices from one extra solve on the same grid
+*/
+
+#ifndef ORF_PDE1DGREEKS_HPP
+#define ORF_PDE1DGREEKS_HPP
+
+#include <orflib/methods/pde/pde1dstrip.hpp>
+
+BEGIN_NAMESPACE(orf)
+
+/** Computes the vega of the job, the change of its price per unit change of all its forward
+    volatilities, from one extra solve with the volatilities shifted by volBump.
+    The extra solve runs on the grid of the passed-in base results of the job, so that the
+    difference of the prices is free of the noise of a moved grid.
+    The delta, gamma and theta come from the base results, see Pde1DResults::getGreeks().
+*/
+double solvePde1DVega(Pde1DJob const& job, Pde1DResults const& baseResults, double volBump = 0.01);
+
+END_NAMESPACE(orf)
+
+#endif  // #ifndef ORF_PDE1DGREEKS_HPP
@@ -5,101 +5,464 @@
 
 #include <orflib/methods/pde/pde1dsolver.hpp>
 #include <orflib/math/interpol/interpolation1d.hpp>
+#include <algorithm>
+#include <cmath>
 
 BEGIN_NAMESPACE(orf)
 
+// the tolerance, relative to the largest value, and the iteration limits of the iterative LCP solvers
+static const double PSORTOLERANCE = 1.0e-10;
+static const size_t PSORMAXITER = 100000;
+static const size_t POLICYMAXITER = 100;
+
+// true if a and b are equal to a relative tolerance, so that uniform sub-steps
+// and flat curves match despite rounding
+static bool closeTo(double a, double b)
+{
+  const double tol = 1.0e-12;
+  return std::fabs(a - b) <= tol * std::max(1.0, std::max(std::fabs(a), std::fabs(b)));
+}
+
 /** Solves backwards from one time step to the previous */
 void Pde1DSolver::solveFromStepToStep(ptrdiff_t step, double DT)
 {
-  // initialise operators
-  GridAxis& grax = gridAxes_[0];
-  deltaOpExplicit_.init(grax.drifts, DT, grax.DX, 1.0 - theta_);
-  deltaOpImplicit_.init(grax.drifts, DT, grax.DX, theta_);
+  keepThetaValues(step, *prevValues, DT);
+  elapsed_ = 0.0;
+  takeStep(step, DT);
+  ++nStepsDone_;
+}
 
-  gammaOpExplicit_.init(grax.variances, DT, grax.DX, 1.0 - theta_);
-  gammaOpImplicit_.init(grax.variances, DT, grax.DX, theta_);
+/** Solves backwards over DT with one step and with two half steps, for the adaptive time stepping.
+    The difference is the root mean square over the interior nodes and the layers.
+*/
+double Pde1DSolver::trySolveFromStepToStep(ptrdiff_t step, double DT, double maxDiff)
+{
+  savedValues_ = *prevValues;
+  elapsed_ = 0.0;
+  takeStep(step, DT);
+  fullValues_ = *prevValues;
+  *prevValues = savedValues_;
+  elapsed_ = 0.0;
+  takeStep(step, 0.5 * DT);
+  takeStep(step, 0.5 * DT);
 
-  // build the explicit and implicit operators
-  opExplicit_.init(grax.NX, 0.0, 1.0, 0.0); // initialize to identity matrix
-  opExplicit_ += deltaOpExplicit_;
-  opExplicit_ += gammaOpExplicit_;
-  opImplicit_.init(grax.NX, 0.0, 1.0, 0.0); // initialize to identity matrix
-  opImplicit_ -= deltaOpImplicit_;
-  opImplicit_ -= gammaOpImplicit_;
+  // the root mean square difference at the interior nodes
+  double diff = 0.0;
+  for (size_t j = 0; j < nLayers_; ++j)
+    for (size_t i = 1; i <= gridAxes_[0].NX; ++i)
+      diff += ((*prevValues)(i, j) - fullValues_(i, j)) * ((*prevValues)(i, j) - fullValues_(i, j));
+  diff = std::sqrt(diff / (nLayers_ * gridAxes_[0].NX));
 
-  // adjust the operators for boundary conditions
-  adjustOpsForBoundaryConditions(opExplicit_, opImplicit_, grax.DX);
+  if (diff > maxDiff) {
+    *prevValues = savedValues_;
+    return diff;
+  }
+  ++nStepsDone_;
+  keepThetaValues(step, savedValues_, DT);
+  // local extrapolation adds one order to the implicit Euler and TR-BDF2 steps; the extrapolated
+  // values need not keep the L-stability of the scheme
+  if (scheme_ == PdeParams::Scheme::TRBDF2)
+    *prevValues += (1.0 / 3.0) * (*prevValues - fullValues_);
+  else if (scheme_ == PdeParams::Scheme::THETA && theta_ == 1.0)
+    *prevValues += 1.0 * (*prevValues - fullValues_);
+  else
+    return diff;
+  // the extrapolation may undershoot the exercise values
+  if (hasObstacles_) {
+    double growth = std::exp(discountRate_ * DT);
+    for (size_t j = 0; j < nLayers_; ++j)
+      if (layerObstacle_[j])
+        for (size_t i = 1; i <= gridAxes_[0].NX; ++i)
+          (*prevValues)(i, j) = std::max((*prevValues)(i, j), growth * obstacles_(i, j));
+  }
+  return diff;
+}
 
-  // Main loop over the layers
-  for (size_t j = 0; j < nLayers_; ++j) {
-    // NOTE: v1 and v2 are read-write views into the corresponding columns
-    // They are not independent copies, so we are modifying in place prevValues and currValues
-    auto v1 = prevValues->col(j);
-    auto v2 = currValues->col(j);
-    opExplicit_.apply(v1, v2);
-    opImplicit_.applyInverse(v2, v1);
+/** The order of the next step; the smoothing steps of the RANNACHER scheme are implicit Euler steps */
+double Pde1DSolver::stepOrder() const
+{
+  if (scheme_ == PdeParams::Scheme::RANNACHER && nStepsDone_ < nSmoothingSteps_)
+    return 1.0;
+  return PdeBase::stepOrder();
+}
+
+/** Keeps the values before the last two steps to the first time, for the theta */
+void Pde1DSolver::keepThetaValues(ptrdiff_t step, Matrix const& values, double DT)
+{
+  if (step > 1)
+    return;
+  // the values before and after a product event at the first time step are not one smooth solution
+  bool smooth = !(step == 0 && thetaStep_ == 1 && stepindex_[1] >= 0);
+  std::swap(results_.nextValues2, results_.nextValues);
+  results_.nextDT2 = smooth ? results_.nextDT : 0.0;
+  results_.nextValues = values;
+  results_.nextDT = DT;
+  thetaStep_ = step;
+}
+
+/** Takes one step of the time stepping scheme */
+void Pde1DSolver::takeStep(ptrdiff_t step, double DT)
+{
+  GridAxis const& grax = gridAxes_[0];
+  switch (scheme_) {
+  case PdeParams::Scheme::THETA:
+    thetaStep(grax, DT, theta_);
+    break;
+  case PdeParams::Scheme::RANNACHER:
+    if (nStepsDone_ < nSmoothingSteps_) {
+      // damp the payoff kinks with two implicit half steps
+      thetaStep(grax, 0.5 * DT, 1.0);
+      thetaStep(grax, 0.5 * DT, 1.0);
+    }
+    else
+      thetaStep(grax, DT, 0.5);
+    break;
+  case PdeParams::Scheme::BDF2:
+    // the values before a product event do not belong to the same solution, so restart
+    bdf2Step(grax, DT, stepindex_[step + 1] >= 0);
+    break;
+  case PdeParams::Scheme::TRBDF2:
+    trbdf2Step(grax, DT);
+    break;
+  default:
+    ORF_ASSERT(0, "Pde1DSolver: unknown time stepping scheme!");
   }
 
   // apply boundary coditions to solution
-  applyBoundaryConditions(*prevValues);
+  if (grax.isUniform())
+    applyBoundaryConditions(*prevValues, grax.zeroAtXmin, grax.zeroAtXmax);
+  else
+    applyBoundaryConditions(*prevValues, grax.spacings, grax.zeroAtXmin, grax.zeroAtXmax);
 }
 
+/** One step of the theta scheme, (I - theta DT L) V(t) = (I + (1 - theta) DT L) V(t + DT) */
+void Pde1DSolver::thetaStep(GridAxis const& grax, double DT, double theta)
+{
+  prepareOps(grax, DT, 1.0 - theta, -theta);
+  elapsed_ += DT;
+  // all layers at once, sharing the implicit operator factorization;
+  // the compact differences have the operator A on the right-hand side even if implicit
+  if (theta < 1.0 || spatialScheme_ == PdeParams::SpatialScheme::COMPACT) {
+    opExplicit_.applyToLayers(*prevValues, *currValues);
+    solveImplicit(*currValues, *prevValues, elapsed_);
+  }
+  else {
+    solveImplicit(*prevValues, *currValues, elapsed_);
+    std::swap(prevValues, currValues);
+  }
+}
+
+/** One step of the variable step BDF2 scheme, from the values at the two later time steps.
+    At a restart only one later time step is available, and the step is implicit Euler. */
+void Pde1DSolver::bdf2Step(GridAxis const& grax, double DT, bool restart)
+{
+  elapsed_ += DT;
+  if (restart || !hasOlder_) {
+    prepareOps(grax, DT, 0.0, -1.0);
+    solveImplicit(*prevValues, *currValues, elapsed_);
+    std::swap(olderValues, prevValues);
+    std::swap(prevValues, currValues);
+  }
+  else {
+    // a0 V(t) - DT L V(t) = a1 V(t + DT) - a2 V(t + DT + prevDT), normalized by a0
+    double w = DT / prevDT_;
+    double a0 = (1.0 + 2.0 * w) / (1.0 + w);
+    double a1 = (1.0 + w) / a0;
+    double a2 = w * w / (1.0 + w) / a0;
+    prepareOps(grax, DT, 0.0, -1.0 / a0);
+    *currValues = a1 * (*prevValues) - a2 * (*olderValues);
+    solveImplicit(*currValues, *olderValues, elapsed_);
+    std::swap(olderValues, prevValues);
+  }
+  hasOlder_ = true;
+  prevDT_ = DT;
+}
+
+/** One step of TR-BDF2: a trapezoidal stage over gamma DT, then a BDF2 stage over the rest.
+    With gamma = 2 - sqrt(2) both stages have the same implicit operator, I - gamma / 2 DT L. */
+void Pde1DSolver::trbdf2Step(GridAxis const& grax, double DT)
+{
+  const double gamma = 2.0 - std::sqrt(2.0);
+  prepareOps(grax, DT, 0.5 * gamma, -0.5 * gamma);
+  opExplicit_.applyToLayers(*prevValues, *currValues);
+  solveImplicit(*currValues, *olderValues, elapsed_ + gamma * DT);
+
+  double c1 = 1.0 / (gamma * (2.0 - gamma));
+  double c2 = (1.0 - gamma) * (1.0 - gamma) / (gamma * (2.0 - gamma));
+  *currValues = c1 * (*olderValues) - c2 * (*prevValues);
+  elapsed_ += DT;
+  solveImplicit(*currValues, *prevValues, elapsed_);
+}
+
+/** Solves the implicit operator for every layer, with the exercise values as obstacle
+    for the layers whose early exercise is enforced */
+void Pde1DSolver::solveImplicit(Matrix const& rhs, Matrix& result, double elapsed)
+{
+  if (!hasObstacles_) {
+    opImplicit_.applyInverseToLayers(rhs, result);
+    return;
+  }
+
+  // the values are discounted after the step, so the obstacle grows at the discount rate
+  double growth = std::exp(discountRate_ * elapsed);
+  size_t n = gridAxes_[0].NX;
+  for (size_t j = 0; j < nLayers_; ++j) {
+    double const* vals = rhs.colptr(j);
+    double* res = result.colptr(j);
+    if (!layerObstacle_[j]) {
+      opImplicit_.applyInverse(vals, res);
+      continue;
+    }
+    for (size_t i = 1; i <= n; ++i)
+      stepObstacle_[i] = growth * obstacles_(i, j);
+    if (exercise_ == PdeParams::Exercise::BRENNAN_SCHWARTZ) {
+      opImplicit_.applyInverseBrennanSchwartz(vals, stepObstacle_, res, layerExerciseSide_[j] < 0);
+      continue;
+    }
+    // the iterative methods start from the right-hand side, projected on the obstacle
+    for (size_t i = 1; i <= n; ++i)
+      res[i] = std::max(vals[i], stepObstacle_[i]);
+    // with the optimal relaxation
+    if (exercise_ == PdeParams::Exercise::PSOR)
+      opImplicit_.applyInversePSOR(vals, stepObstacle_, res, 0.0, PSORTOLERANCE, PSORMAXITER);
+    else
+      opImplicit_.applyInversePolicyIteration(vals, stepObstacle_, res, POLICYMAXITER);
+  }
+}
+
+/** Sets opExplicit_ to I + expCoeff DT L and opImplicit_ to I + impCoeff DT L,
+    adjusted for the boundary conditions. Operators built with the same coefficients
+    are reused, with their factorization. */
+void Pde1DSolver::prepareOps(GridAxis const& grax, double DT, double expCoeff, double impCoeff)
+{
+  bool compact = spatialScheme_ == PdeParams::SpatialScheme::COMPACT;
+  if (!sameCoefficients(grax)) {
+    // remember the coefficients; the implicit operator is factorized on first use
+    opsCached_ = true;
+    cachedDrifts_ = grax.drifts;
+    cachedVariances_ = grax.variances;
+    expBuilt_ = impBuilt_ = false;
+  }
+  // the operators depend on the coefficient times DT only, so that e.g. the implicit half steps
+  // of the Rannacher scheme share the implicit operator of the Crank-Nicolson steps
+  if ((expCoeff != 0.0 || compact) && !(expBuilt_ && closeTo(expCoeff * DT, expCoeffDT_))) {
+    if (compact) {
+      opExplicit_.initCompactConvectionDiffusion(grax.drifts, grax.variances, DT, grax.DX, expCoeff);
+      adjustOpForBoundaryConditions(opExplicit_, grax.DX, grax.zeroAtXmin, grax.zeroAtXmax);
+    }
+    else if (grax.isUniform()) {
+      opExplicit_.initConvectionDiffusion(grax.drifts, grax.variances, DT, grax.DX, expCoeff);
+      adjustOpForBoundaryConditions(opExplicit_, grax.DX, grax.zeroAtXmin, grax.zeroAtXmax);
+    }
+    else {
+      opExplicit_.initConvectionDiffusion(grax.drifts, grax.variances, DT, grax.spacings, expCoeff);
+      adjustOpForBoundaryConditions(opExplicit_, grax.spacings, grax.zeroAtXmin, grax.zeroAtXmax);
+    }
+    expBuilt_ = true;
+    expCoeffDT_ = expCoeff * DT;
+  }
+  if (!(impBuilt_ && closeTo(impCoeff * DT, impCoeffDT_))) {
+    if (compact) {
+      opImplicit_.initCompactConvectionDiffusion(grax.drifts, grax.variances, DT, grax.DX, impCoeff);
+      adjustOpForBoundaryConditions(opImplicit_, grax.DX, grax.zeroAtXmin, grax.zeroAtXmax);
+    }
+    else if (grax.isUniform()) {
+      opImplicit_.initConvectionDiffusion(grax.drifts, grax.variances, DT, grax.DX, impCoeff);
+      adjustOpForBoundaryConditions(opImplicit_, grax.DX, grax.zeroAtXmin, grax.zeroAtXmax);
+    }
+    else {
+      opImplicit_.initConvectionDiffusion(grax.drifts, grax.variances, DT, grax.spacings, impCoeff);
+      adjustOpForBoundaryConditions(opImplicit_, grax.spacings, grax.zeroAtXmin, grax.zeroAtXmax);
+    }
+    impBuilt_ = true;
+    impCoeffDT_ = impCoeff * DT;
+  }
+}
+
+/** Returns true if the operators of the previous step were built with the current coefficients */
+bool Pde1DSolver::sameCoefficients(GridAxis const& grax) const
+{
+  if (!opsCached_)
+    return false;
+  if (grax.drifts.size() != cachedDrifts_.size() || grax.variances.size() != cachedVariances_.size())
+    return false;
+  for (size_t i = 0; i < grax.drifts.size(); ++i) {
+    if (!closeTo(grax.drifts[i], cachedDrifts_[i]) || !closeTo(grax.variances[i], cachedVariances_[i]))
+      return false;
+  }
+  return true;
+}
 
 /** Initializes the layers (grid functions) */
 void Pde1DSolver::initValLayers()
 {
+  opsCached_ = false;   // a new solve may run on a different grid
   ORF_ASSERT(nFactors() == 1, "1D PDE is handles 1 asset only!");
+  if (spatialScheme_ == PdeParams::SpatialScheme::COMPACT) {
+    ORF_ASSERT(gridAxes_[0].isUniform(), "Pde1DSolver: the compact differences need uniform nodes!");
+    ORF_ASSERT(scheme_ == PdeParams::Scheme::THETA || scheme_ == PdeParams::Scheme::RANNACHER,
+      "Pde1DSolver: the compact differences support the THETA and RANNACHER schemes only!");
+  }
   values1.resize(gridAxes_[0].NX + 2, nLayers_);
   values2.resize(gridAxes_[0].NX + 2, nLayers_);
+  values3.zeros(gridAxes_[0].NX + 2, nLayers_);
   // initialize all values to zero
   for (size_t i = 0; i < gridAxes_[0].NX + 2; ++i) {
     for (size_t j = 0; j < nLayers_; ++j) {
       values1(i, j) = values2(i, j) = 0.0;
     }
   }
-  prevValues = &values1; currValues = &values2;
+  prevValues = &values1; currValues = &values2; olderValues = &values3;
+  hasOlder_ = false;
+  nStepsDone_ = 0;
+  results_.nextDT = results_.nextDT2 = 0.0;
+  thetaStep_ = -1;
+
+  // the exercise values of the layers whose early exercise is enforced at every step
+  hasObstacles_ = false;
+  layerObstacle_.assign(nLayers_, 0);
+  layerExerciseSide_.assign(nLayers_, 0);
+  obstacles_.zeros(gridAxes_[0].NX + 2, nLayers_);
+  stepObstacle_.zeros(gridAxes_[0].NX + 2);
+  Vector spots(1);
+  for (size_t j = 0; j < nLayers_; ++j) {
+    if (!enforcesExercise(*products_[j]))
+      continue;
+    // A - theta DT B need not be an M-matrix, which the LCP solvers rely on
+    ORF_ASSERT(spatialScheme_ != PdeParams::SpatialScheme::COMPACT,
+      "Pde1DSolver: the compact differences do not support the enforced early exercise!");
+    layerObstacle_[j] = 1;
+    layerExerciseSide_[j] = products_[j]->exerciseSide();
+    ORF_ASSERT(exercise_ != PdeParams::Exercise::BRENNAN_SCHWARTZ || layerExerciseSide_[j] != 0,
+      "Pde1DSolver: Brennan-Schwartz needs a single exercise boundary!");
+    for (size_t i = 0; i < gridAxes_[0].NX + 2; ++i) {
+      spots[0] = gridAxes_[0].Slevels[i];
+      obstacles_(i, j) = products_[j]->exerciseValue(spots);
+    }
+    hasObstacles_ = true;
+  }
 
   // prepare the results
   results_.times.resize(nSteps_);
-  results_.values.resize(nSteps_);
+  results_.storedValues.reset();
   if (storeAllResults_)
-    results_.values.resize(nSteps_);
+    results_.storedValues = std::make_shared<PdeSliceStore>(timesteps_, gridAxes_[0].NX + 2, nLayers_,
+                                                            storageParams_);
 }
 
 
-/** Evaluates the product at the passed-in time step index */
-void Pde1DSolver::evalProduct(size_t stepIdx)
+/** Sets up the union of the time steps of all products */
+void Pde1DSolver::setTimeSteps(size_t nsteps)
 {
-  ptrdiff_t eventIdx = stepindex_[stepIdx];
-  if (eventIdx >= 0) {             // product event, must evaluate
-    Vector const & payTms = spprod_->payTimes();       // the payment times
-    double fixtime = spprod_->fixTimes()[eventIdx]; // the fixing time
-    Vector spots(1);                                   // one underlying spot
-    for (size_t node = 0; node <= gridAxes_[0].NX + 1; ++node) {
-      spots[0] = gridAxes_[0].Slevels[node];
-      spprod_->eval(eventIdx, spots, (*prevValues)(node, 0));
-      // read out the ammounts
-      Vector const & payAms = spprod_->payAmounts();
-      size_t i = 0;
-      while (fixtime > payTms[i]) ++i;
-      // TODO: fwd discount
-      (*prevValues)(node, 0) = payAms[eventIdx];
+  if (products_.size() == 1) {
+    PdeBase::setTimeSteps(nsteps);
+    layerStepIndex_.assign(1, stepindex_);
+    return;
+  }
+
+  // time steps closer than this are merged
+  const double tol = 1.0e-10;
+  std::vector<std::vector<double>> prodsteps(products_.size());
+  std::vector<std::vector<ptrdiff_t>> prodindex(products_.size());
+  std::vector<double> alltimes;
+  for (size_t j = 0; j < products_.size(); ++j) {
+    if (enforcesExercise(*products_[j]))
+      products_[j]->timeStepsWithoutExercise(nsteps, prodsteps[j], prodindex[j]);
+    else
+      products_[j]->timeSteps(nsteps, prodsteps[j], prodindex[j]);
+    alltimes.insert(alltimes.end(), prodsteps[j].begin(), prodsteps[j].end());
+  }
+  std::sort(alltimes.begin(), alltimes.end());
+  timesteps_.clear();
+  for (size_t i = 0; i < alltimes.size(); ++i)
+    if (timesteps_.empty() || alltimes[i] - timesteps_.back() > tol)
+      timesteps_.push_back(alltimes[i]);
+
+  // map the events of each product to the merged time steps
+  layerStepIndex_.assign(products_.size(), std::vector<ptrdiff_t>(timesteps_.size(), -1));
+  stepindex_.assign(timesteps_.size(), -1);
+  for (size_t j = 0; j < products_.size(); ++j) {
+    for (size_t k = 0; k < prodsteps[j].size(); ++k) {
+      if (prodindex[j][k] < 0)
+        continue;
+      size_t i = std::lower_bound(timesteps_.begin(), timesteps_.end(), prodsteps[j][k] - tol)
+               - timesteps_.begin();
+      layerStepIndex_[j][i] = prodindex[j][k];
+      stepindex_[i] = std::max(stepindex_[i], prodindex[j][k]);
     }
   }
+}
+
+/** Evaluates the products at the passed-in time step index, each in its own layer,
+    on the whole spot axis at once */
+void Pde1DSolver::evalProduct(size_t stepIdx)
+{
+  for (size_t j = 0; j < nLayers_; ++j) {
+    ptrdiff_t eventIdx = layerStepIndex_[j][stepIdx];
+    if (eventIdx < 0)              // no event for this product
+      continue;
+    // TODO: fwd discount
+    products_[j]->evalSlice(eventIdx, gridAxes_[0].Slevels, prevValues->colptr(j));
+    if (spatialScheme_ == PdeParams::SpatialScheme::COMPACT && stepIdx + 1 == nSteps_)
+      smoothPayoff(*products_[j], eventIdx, prevValues->colptr(j));
+  }
   results_.times[stepIdx] = timesteps_[stepIdx];
   if (storeAllResults_)
-    results_.values[stepIdx] = *prevValues;
+    results_.storedValues->store(stepIdx, *prevValues);
+}
+
+/** Replaces the payoff at the nodes at least 3 DX from the edges by its average with the 4th order
+    smoothing kernel of Kreiss, Thomee and Widlund, in units of DX
+      K(x) = 4/3 M4(x) - 1/6 (M4(x - 1) + M4(x + 1))
+    where M4 is the cubic B-spline on [-2, 2]. Without it the payoff kinks and jumps would limit
+    the compact differences to the 2nd order. The integrals use 4-point Gauss-Legendre on each
+    half of the unit intervals, with the continuation values set to zero. */
+void Pde1DSolver::smoothPayoff(Product const& product, size_t eventIdx, double* values)
+{
+  static const double gx[4] = { -0.8611363115940526, -0.3399810435848563, 0.3399810435848563, 0.8611363115940526 };
+  static const double gw[4] = { 0.3478548451374538, 0.6521451548625461, 0.6521451548625461, 0.3478548451374538 };
+  auto bspline = [](double x) {
+    x = std::fabs(x);
+    return x < 1.0 ? 2.0 / 3.0 - x * x + 0.5 * x * x * x : (x < 2.0 ? (2.0 - x) * (2.0 - x) * (2.0 - x) / 6.0 : 0.0);
+  };
+  std::vector<double> xs, ws;
+  for (int k = -6; k < 6; ++k)
+    for (size_t q = 0; q < 4; ++q) {
+      double x = 0.25 * (2 * k + 1) + 0.25 * gx[q];
+      xs.push_back(x);
+      ws.push_back(0.25 * gw[q] * (4.0 / 3.0 * bspline(x) - (bspline(x - 1.0) + bspline(x + 1.0)) / 6.0));
+    }
+
+  GridAxis const& grax = gridAxes_[0];
+  size_t m = xs.size(), n = grax.NX + 2;
+  if (n < 7)
+    return;
+  Matrix spots((n - 6) * m, 1);
+  for (size_t i = 3; i + 3 < n; ++i)
+    for (size_t q = 0; q < m; ++q)
+      spots((i - 3) * m + q, 0) = grax.coordinateChange->fromDiffusedToReal(grax.Xlevels[i] + xs[q] * grax.DX);
+  Vector payoffs(spots.n_rows, arma::fill::zeros);
+  product.evalSlice(eventIdx, spots, payoffs.memptr());
+  for (size_t i = 3; i + 3 < n; ++i) {
+    double v = 0.0;
+    for (size_t q = 0; q < m; ++q)
+      v += ws[q] * payoffs[(i - 3) * m + q];
+    values[i] = v;
+  }
 }
 
 /** Stores the solver results */
 void Pde1DSolver::storeResults()
 {
   results_.gridAxes = gridAxes_;
+  results_.nTimeSteps = nStepsTaken_;
+  results_.nRejectedSteps = nStepsRejected_;
+  results_.finalValues = *prevValues;
   results_.prices.resize(nLayers_);
   for (size_t j = 0; j < nLayers_; ++j) {
     double X0 = gridAxes_[0].coordinateChange->fromRealToDiffused(spots_[0]);
-    Vector temp(prevValues->col(j));
-    LinearInterpolation1D<Vector> interp(gridAxes_[0].Xlevels, temp);
+    ArrayView layer(prevValues->colptr(j), prevValues->n_rows);
+    LinearInterpolation1D<ArrayView> interp(gridAxes_[0].Xlevels, layer);
     results_.prices[j] = interp.getValue(X0);
   }
 }
@@ -109,6 +472,9 @@ void Pde1DSolver::storeResults()
 void Pde1DSolver::discountFromStepToStep(double df)
 {
   *prevValues *= df;
+  // BDF2 combines the values of two steps, so the older ones are discounted to the same time
+  if (scheme_ == PdeParams::Scheme::BDF2 && hasOlder_)
+    *olderValues *= df;
 }
 
 /** Aligns the grid to given value */
@@ -122,4 +488,17 @@ void Pde1DSolver::setAlignment()
   }
 }
 
+/** The grid may end at a knock-out level only if every product is knocked out there */
+void Pde1DSolver::knockOutLevels(double& lower, double& upper) const
+{
+  lower = HUGE_VAL;
+  upper = 0.0;
+  for (size_t j = 0; j < products_.size(); ++j) {
+    double lo, hi;
+    products_[j]->getKnockOutLevels(lo, hi);
+    lower = std::min(lower, lo);
+    upper = std::max(upper, hi);
+  }
+}
+
 END_NAMESPACE(orf)
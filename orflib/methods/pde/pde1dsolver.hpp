@@ -16,7 +16,9 @@ BEGIN_NAMESPACE(orf)
 class Pde1DSolver : public PdeBase
 {
 public:
-  /** Ctor */
+  /** Ctor. The results are written to the passed-in object, so that solvers running
+      concurrently must each have their own results and their own product.
+  */
   Pde1DSolver(SPtrProduct product,
               SPtrYieldCurve discountYieldCurve,
               double spot,
@@ -24,10 +26,39 @@ public:
               SPtrVolatilityTermStructure vol,
               Pde1DResults& results,
               bool storeAllResults = false)
-  : PdeBase(product), results_(results), storeAllResults_(storeAllResults)
+  : PdeBase(product), results_(results), storeAllResults_(storeAllResults),
+    products_(1, product), opsCached_(false), expBuilt_(false), impBuilt_(false), hasOlder_(false)
   {
     nAssets_ = product->nAssets();
-    nLayers_ = 1;  // currently we solve for only one variable
+    nLayers_ = 1;
+    spdiscyc_ = discountYieldCurve;
+    spots_.push_back(spot),
+    spaccrycs_.push_back(discountYieldCurve);
+    divyields_.push_back(divyield);
+    vols_.push_back(vol);
+  }
+
+  /** Ctor for solving several products on the same grid in one backward sweep,
+      one layer per product, e.g. a ladder of strikes.
+      The time steps are the union of the time steps of all products.
+      The grid is aligned for the first product.
+  */
+  Pde1DSolver(std::vector<SPtrProduct> const& products,
+              SPtrYieldCurve discountYieldCurve,
+              double spot,
+              double divyield,
+              SPtrVolatilityTermStructure vol,
+              Pde1DResults& results,
+              bool storeAllResults = false)
+  : PdeBase(products.empty() ? SPtrProduct() : products.front()),
+    results_(results), storeAllResults_(storeAllResults),
+    products_(products), opsCached_(false), expBuilt_(false), impBuilt_(false), hasOlder_(false)
+  {
+    ORF_ASSERT(!products_.empty(), "Pde1DSolver: no products!");
+    nAssets_ = products_.front()->nAssets();
+    for (size_t j = 1; j < products_.size(); ++j)
+      ORF_ASSERT(products_[j]->nAssets() == nAssets_, "Pde1DSolver: the products depend on different numbers of assets!");
+    nLayers_ = products_.size();
     spdiscyc_ = discountYieldCurve;
     spots_.push_back(spot),
     spaccrycs_.push_back(discountYieldCurve);
@@ -38,9 +69,19 @@ public:
   /** Dtor */
   virtual ~Pde1DSolver() override {}
 
+  /** Sets up the union of the time steps of all products */
+  virtual void setTimeSteps(size_t nsteps) override;
+
   /** Solves backwards from one time step to the previous */
   virtual void solveFromStepToStep(ptrdiff_t step, double DT) override;
 
+  /** Solves backwards over DT with one step and with two half steps, for the adaptive time stepping;
+      returns the root mean square difference over the interior nodes of all layers */
+  virtual double trySolveFromStepToStep(ptrdiff_t step, double DT, double maxDiff) override;
+
+  /** The order of the next step; 1 for the implicit Euler smoothing steps of the RANNACHER scheme */
+  virtual double stepOrder() const override;
+
   /** Initializes the layers.
       Each layer (grid function) corresponds to variable solved on the grid.
   */
@@ -59,18 +100,71 @@ public:
   /** Aligns the grid to given value*/
   virtual void setAlignment() override;
 
+  /** The knock-out levels shared by all the products */
+  virtual void knockOutLevels(double& lower, double& upper) const override;
+
 protected:
 
+  /** Returns true if the operators built at a previous time step used the current
+      axis drifts and variances */
+  bool sameCoefficients(GridAxis const& grax) const;
+
+  /** Sets the explicit operator to I + expCoeff DT L, unless expCoeff is 0, and the implicit
+      operator to I + impCoeff DT L, rebuilding only the operators that changed.
+      With the compact differences they are A + expCoeff DT B and A + impCoeff DT B,
+      see TridiagonalOp1D::initCompactConvectionDiffusion(), and the explicit one is always set. */
+  void prepareOps(GridAxis const& grax, double DT, double expCoeff, double impCoeff);
+
+  /** Keeps the values before a step to the first time or to the next, for the theta */
+  void keepThetaValues(ptrdiff_t step, Matrix const& values, double DT);
+
+  /** Takes one step of the time stepping scheme and applies the boundary conditions */
+  void takeStep(ptrdiff_t step, double DT);
+
+  /** Solves the implicit operator for every layer. The layers whose early exercise is enforced
+      solve the linear complementarity problem, with the exercise values as obstacle,
+      compounded to the time elapsed since the start of the step. */
+  void solveImplicit(Matrix const& rhs, Matrix& result, double elapsed);
+
+  /** Smooths the payoff of the product at maturity for the compact differences */
+  void smoothPayoff(Product const& product, size_t eventIdx, double* values);
+
+  /** One step of each time stepping scheme, from *prevValues to *prevValues */
+  void thetaStep(GridAxis const& grax, double DT, double theta);
+  void bdf2Step(GridAxis const& grax, double DT, bool restart);
+  void trbdf2Step(GridAxis const& grax, double DT);
+
   //state
-  DeltaOp1D<Vector> deltaOpExplicit_, deltaOpImplicit_;
-  GammaOp1D<Vector> gammaOpExplicit_, gammaOpImplicit_;
   TridiagonalOp1D<Vector> opExplicit_, opImplicit_;
 
   bool storeAllResults_;
   Pde1DResults& results_;
 
-  Matrix values1, values2;  // each row corresponds to a spot node, each column to a variable
+  Matrix values1, values2, values3;  // each row corresponds to a spot node, each column to a variable
   Matrix* prevValues, * currValues;
+  Matrix* olderValues;      // the values one step before prevValues for BDF2, scratch for TR-BDF2
+
+  std::vector<SPtrProduct> products_;                  // one product per layer
+  std::vector<std::vector<ptrdiff_t>> layerStepIndex_; // for each layer, the event index of each time step
+
+  bool opsCached_;                          // true if the operators were built at a previous step
+  Vector cachedDrifts_, cachedVariances_;   // the coefficients the operators were built with
+  bool expBuilt_, impBuilt_;                // true if the operators match the cached coefficients
+  double expCoeffDT_;                       // the coefficient times DT of the explicit operator
+  double impCoeffDT_;                       // the coefficient times DT of the implicit operator
+
+  bool hasOlder_;                           // true if olderValues holds the values for BDF2
+  double prevDT_;                           // the previous time step, for BDF2
+  size_t nStepsDone_;                       // number of steps taken since maturity
+  Matrix savedValues_, fullValues_;         // the values before an adaptive step, and after one full step
+  double elapsed_;                          // the time elapsed since the start of the step, undiscounted
+  ptrdiff_t thetaStep_;                     // the step of the values last kept for the theta, -1 if none
+
+  bool hasObstacles_;                       // true if the early exercise of some layer is enforced
+  std::vector<char> layerObstacle_;         // for each layer, true if its early exercise is enforced
+  std::vector<int> layerExerciseSide_;      // for each layer, the exercise side of its product
+  Matrix obstacles_;                        // the exercise values at each node, for each layer
+  Vector stepObstacle_;                     // the exercise values compounded to the end of a stage
 
 };
 
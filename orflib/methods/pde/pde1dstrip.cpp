@@ -0,0 +1,55 @@
+/**
+@file  pde1dstrip.cpp
+@brief Implementation of the parallel solution of a strip of 1-dim PDE pricing jobs
+*/
+
+#include <orflib/methods/pde/pde1dstrip.hpp>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+BEGIN_NAMESPACE(orf)
+
+std::vector<Pde1DResults> solvePde1DStrip(std::vector<Pde1DJob> const& jobs, size_t nThreads)
+{
+  std::vector<Pde1DResults> results(jobs.size());
+  std::vector<std::exception_ptr> errors(jobs.size());
+  if (jobs.empty())
+    return results;
+
+  if (nThreads == 0)
+    nThreads = std::max(1u, std::thread::hardware_concurrency());
+  nThreads = std::min(nThreads, jobs.size());
+
+  // the workers take the next unsolved job until there are none left
+  std::atomic<size_t> nextJob(0);
+  auto worker = [&]() {
+    for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+      try {
+        Pde1DJob const& job = jobs[i];
+        ORF_ASSERT(job.product, "solvePde1DStrip: missing product!");
+        Pde1DSolver solver(job.product->clone(), job.discountCurve, job.spot, job.divYield,
+                           job.vol, results[i], job.storeAllResults);
+        solver.solve(job.params);
+      }
+      catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < nThreads; ++t)
+    pool.emplace_back(worker);
+  worker();                      // the calling thread works too
+  for (auto& th : pool)
+    th.join();
+
+  for (size_t i = 0; i < errors.size(); ++i)
+    if (errors[i])
+      std::rethrow_exception(errors[i]);
+  return results;
+}
+
+END_NAMESPACE(orf)
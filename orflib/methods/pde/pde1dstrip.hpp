@@ -0,0 +1,47 @@
+/**
+@file  pde1dstrip.hpp
+@brief Parallel solution of a strip of independent 1-dim PDE pricing jobs
+*/
+
+#ifndef ORF_PDE1DSTRIP_HPP
+#define ORF_PDE1DSTRIP_HPP
+
+#include <orflib/methods/pde/pde1dsolver.hpp>
+#include <vector>
+
+BEGIN_NAMESPACE(orf)
+
+/** One 1-dim PDE pricing job: a product, its market data and the PDE parameters */
+struct Pde1DJob
+{
+  SPtrProduct product;
+  SPtrYieldCurve discountCurve;
+  double spot;
+  double divYield;
+  SPtrVolatilityTermStructure vol;
+  PdeParams params;
+  bool storeAllResults;
+
+  /** Default ctor */
+  Pde1DJob() : spot(0.0), divYield(0.0), storeAllResults(false) {}
+
+  /** Initializing ctor */
+  Pde1DJob(SPtrProduct prod, SPtrYieldCurve discountCrv, double spt, double divyld,
+           SPtrVolatilityTermStructure volatility, PdeParams const& pdeparams,
+           bool storeAll = false)
+  : product(prod), discountCurve(discountCrv), spot(spt), divYield(divyld),
+    vol(volatility), params(pdeparams), storeAllResults(storeAll)
+  {}
+};
+
+/** Solves the jobs on a pool of nThreads threads and returns their results, in the order of the jobs.
+    If nThreads is 0, it uses as many threads as the hardware supports.
+    Each job runs its own solver on a clone of its product, so the same product may
+    appear in several jobs. The yield curves and volatilities are only read and may be shared.
+    If a job fails, the remaining jobs are still solved and the first error is rethrown.
+*/
+std::vector<Pde1DResults> solvePde1DStrip(std::vector<Pde1DJob> const& jobs, size_t nThreads = 0);
+
+END_NAMESPACE(orf)
+
+#endif  // #ifndef ORF_PDE1DSTRIP_HPP
@@ -0,0 +1,341 @@
+/**
+@file  pde2dsolver.cpp
+@brief Implementation of the 2-dim PDE solver class
+*/
+
+#include <orflib/methods/pde/pde2dsolver.hpp>
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <thread>
+
+BEGIN_NAMESPACE(orf)
+
+// the threads are started for every batch of line solves, which only pays off on large grids
+static const size_t MINNODESPERTHREAD = 20000;
+
+/** Runs body(begin, end, thread) on contiguous chunks of the lines [begin, end),
+    one chunk per thread, and rethrows the first error */
+template <typename BODY>
+void Pde2DSolver::forEachLineChunk(size_t begin, size_t end, BODY body)
+{
+  size_t nLines = end - begin;
+  size_t nThreads = std::min(nThreadsUsed_, nLines);
+  if (nThreads <= 1) {
+    body(begin, end, size_t(0));
+    return;
+  }
+
+  std::vector<std::exception_ptr> errors(nThreads);
+  auto worker = [&](size_t t) {
+    try {
+      body(begin + t * nLines / nThreads, begin + (t + 1) * nLines / nThreads, t);
+    }
+    catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < nThreads; ++t)
+    pool.emplace_back(worker, t);
+  worker(0);                     // the calling thread works too
+  for (auto& th : pool)
+    th.join();
+
+  for (size_t t = 0; t < nThreads; ++t)
+    if (errors[t])
+      std::rethrow_exception(errors[t]);
+}
+
+/** Solves backwards from one time step to the previous, with one step of the ADI scheme.
+    With F = F_12 + F_1 + F_2 the operator times DT and U the values at the later time, the
+    predictor is Y0 = U + F U and the corrections along each axis are Y_k = Y_k-1 + theta F_k (Y_k - U).
+    Douglas stops there. Craig-Sneyd and Hundsdorfer-Verwer correct the predictor with the
+    operator applied to the corrected values Y and repeat the corrections along each axis.
+*/
+void Pde2DSolver::solveFromStepToStep(ptrdiff_t, double DT)
+{
+  double theta;
+  switch (adiScheme_) {
+  case PdeParams::AdiScheme::DOUGLAS:
+    theta = 0.5;
+    break;
+  case PdeParams::AdiScheme::CRAIG_SNEYD:
+    theta = 1.0 / 3.0;
+    break;
+  case PdeParams::AdiScheme::HUNDSDORFER_VERWER:
+    theta = 0.5 + std::sqrt(3.0) / 6.0;
+    break;
+  default:
+    ORF_ASSERT(0, "Pde2DSolver: unknown ADI scheme!");
+  }
+  prepareOps(DT, theta);
+  size_t n = values_.n_elem;
+
+  // the explicit predictor
+  applyMixed(DT, values_, Fm_);
+  applyAxis(0, values_, Fa_[0]);
+  applyAxis(1, values_, Fa_[1]);
+  for (size_t e = 0; e < n; ++e)
+    Y0_[e] = values_[e] + Fm_[e] + Fa_[0][e] + Fa_[1][e];
+
+  // the implicit corrections, (I - theta F_k) Y_k = Y_k-1 - theta F_k V, into Y_
+  auto correct = [&](Matrix const& start, Matrix const* F) {
+    for (size_t e = 0; e < n; ++e)
+      rhs_[e] = start[e] - theta * F[0][e];
+    solveAxis(0, rhs_, Y_);
+    for (size_t e = 0; e < n; ++e)
+      rhs_[e] = Y_[e] - theta * F[1][e];
+    solveAxis(1, rhs_, Y_);
+    applyBoundaryConditions(Y_);
+  };
+  correct(Y0_, Fa_);
+
+  if (adiScheme_ != PdeParams::AdiScheme::DOUGLAS) {
+    applyMixed(DT, Y_, Gm_);
+    applyAxis(0, Y_, Ga_[0]);
+    applyAxis(1, Y_, Ga_[1]);
+    if (adiScheme_ == PdeParams::AdiScheme::CRAIG_SNEYD) {
+      // the modified Craig-Sneyd scheme of in 't Hout and Welfert
+      for (size_t e = 0; e < n; ++e) {
+        double dm = Gm_[e] - Fm_[e];
+        Y0_[e] += theta * dm + (0.5 - theta) * (dm + Ga_[0][e] - Fa_[0][e] + Ga_[1][e] - Fa_[1][e]);
+      }
+      correct(Y0_, Fa_);
+    }
+    else {
+      for (size_t e = 0; e < n; ++e)
+        Y0_[e] += 0.5 * (Gm_[e] - Fm_[e] + Ga_[0][e] - Fa_[0][e] + Ga_[1][e] - Fa_[1][e]);
+      correct(Y0_, Ga_);
+    }
+  }
+  std::swap(values_, Y_);
+}
+
+/** Builds the explicit operators I + DT L_k and the implicit operators I - theta DT L_k
+    of each axis, and the weights of the mixed derivative term */
+void Pde2DSolver::prepareOps(double DT, double theta)
+{
+  for (size_t k = 0; k < 2; ++k) {
+    GridAxis const& grax = gridAxes_[k];
+    if (grax.isUniform()) {
+      opExplicit_[k].initConvectionDiffusion(grax.drifts, grax.variances, DT, grax.DX, 1.0);
+      adjustOpForBoundaryConditions(opExplicit_[k], grax.DX);
+      opImplicit_[k].initConvectionDiffusion(grax.drifts, grax.variances, DT, grax.DX, -theta);
+      adjustOpForBoundaryConditions(opImplicit_[k], grax.DX);
+    }
+    else {
+      opExplicit_[k].initConvectionDiffusion(grax.drifts, grax.variances, DT, grax.spacings, 1.0);
+      adjustOpForBoundaryConditions(opExplicit_[k], grax.spacings);
+      opImplicit_[k].initConvectionDiffusion(grax.drifts, grax.variances, DT, grax.spacings, -theta);
+      adjustOpForBoundaryConditions(opImplicit_[k], grax.spacings);
+    }
+
+    // the three-point first derivative on unequal intervals; central differences if uniform
+    for (size_t b = 0; b < 3; ++b)
+      crossWeights_[k][b].resize(grax.NX);
+    for (size_t i = 1; i <= grax.NX; ++i) {
+      double hm = grax.DXlow(i), hp = grax.DXhigh(i), hs = hm + hp;
+      double vol = grax.vols[i - 1];
+      crossWeights_[k][0][i - 1] = -vol * hp / (hm * hs);
+      crossWeights_[k][1][i - 1] = vol * (hp - hm) / (hm * hp);
+      crossWeights_[k][2][i - 1] = vol * hm / (hp * hs);
+    }
+  }
+}
+
+/** Sets result to DT L_k vals at the interior nodes. The lines of the first axis are the
+    columns of the values, those of the second axis are the rows. */
+void Pde2DSolver::applyAxis(size_t k, Matrix const& vals, Matrix& result)
+{
+  size_t n0 = gridAxes_[0].NX, n1 = gridAxes_[1].NX;
+  if (k == 0) {
+    forEachLineChunk(1, n1 + 1, [&](size_t j0, size_t j1, size_t) {
+      for (size_t j = j0; j < j1; ++j) {
+        double* res = result.colptr(j);
+        double const* v = vals.colptr(j);
+        opExplicit_[0].apply(v, res);
+        for (size_t i = 1; i <= n0; ++i)
+          res[i] -= v[i];
+      }
+    });
+  }
+  else {
+    forEachLineChunk(1, n0 + 1, [&](size_t i0, size_t i1, size_t) {
+      opExplicit_[1].applyBatch(vals, result, i0, i1);
+      for (size_t j = 1; j <= n1; ++j) {
+        double* res = result.colptr(j);
+        double const* v = vals.colptr(j);
+        for (size_t i = i0; i < i1; ++i)
+          res[i] -= v[i];
+      }
+    });
+  }
+}
+
+/** Sets result to DT rho sigma_1 sigma_2 d2 vals / dX1 dX2 at the interior nodes,
+    with the product of the three-point first derivatives along each axis */
+void Pde2DSolver::applyMixed(double DT, Matrix const& vals, Matrix& result)
+{
+  size_t n0 = gridAxes_[0].NX, n1 = gridAxes_[1].NX;
+  if (correlation_ == 0.0) {
+    result.zeros();
+    return;
+  }
+
+  Vector const* w0 = crossWeights_[0];
+  Vector const* w1 = crossWeights_[1];
+  forEachLineChunk(1, n1 + 1, [&](size_t j0, size_t j1, size_t) {
+    for (size_t j = j0; j < j1; ++j) {
+      double* res = result.colptr(j);
+      for (size_t i = 1; i <= n0; ++i)
+        res[i] = 0.0;
+      for (size_t b = 0; b < 3; ++b) {
+        double c = DT * correlation_ * w1[b][j - 1];
+        if (c == 0.0)
+          continue;
+        double const* v = vals.colptr(j - 1 + b);
+        for (size_t i = 1; i <= n0; ++i)
+          res[i] += c * (w0[0][i - 1] * v[i - 1] + w0[1][i - 1] * v[i] + w0[2][i - 1] * v[i + 1]);
+      }
+    }
+  });
+}
+
+/** Solves (I - theta DT L_k) result = rhs along every grid line of the axis k, with the batched
+    tridiagonal solver. The lines of the first axis are solved on the transposed values, so that
+    the values of all lines at each node are contiguous. */
+void Pde2DSolver::solveAxis(size_t k, Matrix const& rhs, Matrix& result)
+{
+  size_t n0 = gridAxes_[0].NX, n1 = gridAxes_[1].NX;
+  if (k == 0) {
+    trans_ = rhs.t();
+    forEachLineChunk(1, n1 + 1, [&](size_t j0, size_t j1, size_t t) {
+      opImplicit_[0].applyInverseBatch(trans_, transRes_, j0, j1, work_[t]);
+    });
+    result = transRes_.t();
+  }
+  else {
+    forEachLineChunk(1, n0 + 1, [&](size_t i0, size_t i1, size_t t) {
+      opImplicit_[1].applyInverseBatch(rhs, result, i0, i1, work_[t]);
+    });
+  }
+}
+
+/** Extrapolates the values to the edge nodes, with the same conditions as the 1-dim solver,
+    first along the second axis and then along the first, which also sets the corners */
+void Pde2DSolver::applyBoundaryConditions(Matrix& vals) const
+{
+  GridAxis const& ax0 = gridAxes_[0];
+  GridAxis const& ax1 = gridAxes_[1];
+  size_t n0 = ax0.NX, n1 = ax1.NX;
+  double r0 = ax0.DXlow(1) / ax0.DXhigh(1), q0 = ax0.DXhigh(n0) / ax0.DXlow(n0);
+  double r1 = ax1.DXlow(1) / ax1.DXhigh(1), q1 = ax1.DXhigh(n1) / ax1.DXlow(n1);
+  for (size_t i = 1; i <= n0; ++i) {
+    vals(i, 0) = vals(i, 1) + r1 * (vals(i, 1) - vals(i, 2));
+    vals(i, n1 + 1) = vals(i, n1) + q1 * (vals(i, n1) - vals(i, n1 - 1));
+  }
+  for (size_t j = 0; j <= n1 + 1; ++j) {
+    vals(0, j) = vals(1, j) + r0 * (vals(1, j) - vals(2, j));
+    vals(n0 + 1, j) = vals(n0, j) + q0 * (vals(n0, j) - vals(n0 - 1, j));
+  }
+}
+
+/** Initializes the values and the work space */
+void Pde2DSolver::initValLayers()
+{
+  ORF_ASSERT(nFactors() == 2, "Pde2DSolver: the grid must have two axes!");
+  ORF_ASSERT(spatialScheme_ == PdeParams::SpatialScheme::CENTRAL,
+    "Pde2DSolver: only the central differences are supported!");
+  ORF_ASSERT(!enforcesExercise(*spprod_),
+    "Pde2DSolver: the early exercise can only be taken at the product fixings!");
+  // the ADI schemes are of second order, so the drifts are calibrated as for Crank-Nicolson
+  driftTheta_ = 0.5;
+
+  size_t N0 = gridAxes_[0].NX + 2, N1 = gridAxes_[1].NX + 2;
+  values_.zeros(N0, N1);
+  // the spots at the nodes, in the column-wise order of the values
+  nodeSpots_.set_size(N0 * N1, 2);
+  for (size_t j = 0; j < N1; ++j) {
+    for (size_t i = 0; i < N0; ++i) {
+      nodeSpots_(i + j * N0, 0) = gridAxes_[0].Slevels[i];
+      nodeSpots_(i + j * N0, 1) = gridAxes_[1].Slevels[j];
+    }
+  }
+  Y0_.zeros(N0, N1);
+  Y_.zeros(N0, N1);
+  rhs_.zeros(N0, N1);
+  Fm_.zeros(N0, N1);
+  Gm_.zeros(N0, N1);
+  for (size_t k = 0; k < 2; ++k) {
+    Fa_[k].zeros(N0, N1);
+    Ga_[k].zeros(N0, N1);
+  }
+  trans_.zeros(N1, N0);
+  transRes_.zeros(N1, N0);
+
+  size_t nThreads = nThreads_ > 0 ? nThreads_ : std::max(1u, std::thread::hardware_concurrency());
+  nThreadsUsed_ = std::max(size_t(1), std::min(nThreads, N0 * N1 / MINNODESPERTHREAD));
+  work_.resize(nThreadsUsed_);
+
+  // prepare the results
+  results_.times.resize(nSteps_);
+  results_.storedValues.reset();
+  if (storeAllResults_)
+    results_.storedValues = std::make_shared<PdeSliceStore>(timesteps_, N0, N1, storageParams_);
+}
+
+/** Evaluates the product at the passed-in time step index */
+void Pde2DSolver::evalProduct(size_t stepIdx)
+{
+  ptrdiff_t eventIdx = stepindex_[stepIdx];
+  if (eventIdx >= 0)
+    spprod_->evalSlice(eventIdx, nodeSpots_, values_.memptr());
+  results_.times[stepIdx] = timesteps_[stepIdx];
+  if (storeAllResults_)
+    results_.storedValues->store(stepIdx, values_);
+}
+
+/** Stores the solver results; the price is interpolated bilinearly at the spots */
+void Pde2DSolver::storeResults()
+{
+  results_.gridAxes = gridAxes_;
+  results_.nTimeSteps = nStepsTaken_;
+  results_.nRejectedSteps = nStepsRejected_;
+
+  size_t idx[2];
+  double wgt[2];
+  for (size_t k = 0; k < 2; ++k) {
+    Vector const& X = gridAxes_[k].Xlevels;
+    double X0 = gridAxes_[k].coordinateChange->fromRealToDiffused(spots_[k]);
+    size_t i = std::upper_bound(X.begin() + 1, X.end() - 1, X0) - X.begin();
+    idx[k] = i - 1;
+    wgt[k] = (X0 - X[i - 1]) / (X[i] - X[i - 1]);
+  }
+  size_t i = idx[0], j = idx[1];
+  results_.prices.resize(1);
+  results_.prices[0] = (1.0 - wgt[0]) * (1.0 - wgt[1]) * values_(i, j)
+                     + wgt[0] * (1.0 - wgt[1]) * values_(i + 1, j)
+                     + (1.0 - wgt[0]) * wgt[1] * values_(i, j + 1)
+                     + wgt[0] * wgt[1] * values_(i + 1, j + 1);
+}
+
+/** Discounts the values on the current time step, by applying
+    the passed-in one-step discount factor. */
+void Pde2DSolver::discountFromStepToStep(double df)
+{
+  values_ *= df;
+}
+
+/** Aligns the grid to given value */
+void Pde2DSolver::setAlignment()
+{
+  if (spprod_->needsAlignment()) {
+    alignments_ = spprod_->getAlignmentVector();
+  }
+  else {
+    alignments_ = spots_;
+  }
+}
+
+END_NAMESPACE(orf)
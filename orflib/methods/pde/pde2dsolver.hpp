@@ -0,0 +1,121 @@
+/**
+@file  pde2dsolver.hpp
+@brief Definition of the 2-dim PDE solver class
+*/
+
+#ifndef ORF_PDE2DSOLVER_HPP
+#define ORF_PDE2DSOLVER_HPP
+
+#include <orflib/methods/pde/pdebase.hpp>
+#include <orflib/methods/pde/tridiagonalops1d.hpp>
+#include <orflib/methods/pde/pderesults.hpp>
+
+BEGIN_NAMESPACE(orf)
+
+/** The 2-d pde solver class, for products on two correlated assets in the Black-Scholes model.
+    It steps with the alternating direction implicit scheme set in the PdeParams: each step
+    is an explicit predictor with the full operator, followed by implicit corrections along
+    each axis, which are batches of independent tridiagonal solves, one per grid line.
+    The mixed derivative term of the correlation is always explicit.
+    Both assets accrue on the discount curve.
+*/
+class Pde2DSolver : public PdeBase
+{
+public:
+  /** Ctor from the product, the market data of the two assets and their correlation.
+      The results are written to the passed-in object.
+  */
+  Pde2DSolver(SPtrProduct product,
+              SPtrYieldCurve discountYieldCurve,
+              Vector const& spots,
+              Vector const& divyields,
+              std::vector<SPtrVolatilityTermStructure> const& vols,
+              double correlation,
+              Pde2DResults& results,
+              bool storeAllResults = false)
+  : PdeBase(product), results_(results), storeAllResults_(storeAllResults), correlation_(correlation)
+  {
+    nAssets_ = product->nAssets();
+    ORF_ASSERT(nAssets_ == 2, "Pde2DSolver: the product must depend on two assets!");
+    ORF_ASSERT(spots.size() == 2, "Pde2DSolver: missing or redundant spots!");
+    ORF_ASSERT(divyields.size() == 2, "Pde2DSolver: missing or redundant dividend yields!");
+    ORF_ASSERT(vols.size() == 2, "Pde2DSolver: missing or redundant volatilities!");
+    ORF_ASSERT(correlation >= -1.0 && correlation <= 1.0, "Pde2DSolver: the correlation must be between -1 and 1!");
+    nLayers_ = 1;
+    spdiscyc_ = discountYieldCurve;
+    for (size_t i = 0; i < 2; ++i) {
+      spots_.push_back(spots[i]);
+      spaccrycs_.push_back(discountYieldCurve);
+      divyields_.push_back(divyields[i]);
+      vols_.push_back(vols[i]);
+    }
+  }
+
+  /** Dtor */
+  virtual ~Pde2DSolver() override {}
+
+  /** Solves backwards from one time step to the previous */
+  virtual void solveFromStepToStep(ptrdiff_t step, double DT) override;
+
+  /** Initializes the values on the grid */
+  virtual void initValLayers() override;
+
+  /** Evaluates the product at the passed-in time step index */
+  virtual void evalProduct(size_t stepIdx) override;
+
+  /** Stores the solver results */
+  virtual void storeResults() override;
+
+  /** Discounts the values on the current time step, by applying
+      the passed-in one-step discount factor. */
+  virtual void discountFromStepToStep(double df) override;
+
+  /** Aligns the grid to given value*/
+  virtual void setAlignment() override;
+
+protected:
+
+  /** Builds the operators I + coeff DT L_k of each axis k for the current coefficients,
+      adjusted for the boundary conditions */
+  void prepareOps(double DT, double theta);
+
+  /** Sets result to DT L_k vals along the axis k at the interior nodes */
+  void applyAxis(size_t k, Matrix const& vals, Matrix& result);
+
+  /** Sets result to DT L_12 vals, the mixed derivative term, at the interior nodes */
+  void applyMixed(double DT, Matrix const& vals, Matrix& result);
+
+  /** Solves (I - theta DT L_k) result = rhs along every grid line of the axis k */
+  void solveAxis(size_t k, Matrix const& rhs, Matrix& result);
+
+  /** Extrapolates the values to the edge nodes of both axes */
+  void applyBoundaryConditions(Matrix& vals) const;
+
+  /** Runs body(begin, end, thread) on nThreadsUsed_ contiguous chunks of the lines [begin, end) */
+  template <typename BODY>
+  void forEachLineChunk(size_t begin, size_t end, BODY body);
+
+  // state
+  Pde2DResults& results_;
+  bool storeAllResults_;
+  double correlation_;
+
+  TridiagonalOp1D<Vector> opExplicit_[2], opImplicit_[2];   // I + DT L_k and I - theta DT L_k
+  Vector crossWeights_[2][3];     // the three-point first derivative weights at the interior nodes,
+                                  // times the vols, for the mixed derivative term
+  size_t nThreadsUsed_;           // threads used for the line solves of this grid
+  std::vector<TridiagonalWorkspace> work_;  // one workspace per thread
+
+  Matrix values_;                 // the values, each row for a node of the first axis,
+                                  // each column for a node of the second axis
+  Matrix nodeSpots_;              // the spots of both assets at each node, a row per node
+  Matrix Y0_, Y_, rhs_;           // the predictor, the current stage and its right-hand side
+  Matrix Fm_, Fa_[2];             // DT times the mixed and the axis operators applied to the values
+  Matrix Gm_, Ga_[2];             // the same applied to the predicted values, for the corrector
+  Matrix trans_, transRes_;       // transposed right-hand side and solution, for the lines of the first axis
+
+};
+
+END_NAMESPACE(orf)
+
+#endif  // #ifndef ORF_PDE2DSOLVER_HPP
@@ -4,6 +4,8 @@
 */
 
 #include <orflib/methods/pde/pdebase.hpp>
+#include <algorithm>
+#include <cmath>
 
 BEGIN_NAMESPACE(orf)
 
@@ -11,11 +13,26 @@ BEGIN_NAMESPACE(orf)
 */
 void PdeBase::solve(PdeParams const& params)
 {
-  // store the Theta
+  // store the Theta and the time stepping scheme
   theta_ = params.theta;
-  // get the time steps
-  spprod_->timeSteps(params.nTimeSteps, timesteps_, stepindex_);
+  scheme_ = params.scheme;
+  nSmoothingSteps_ = params.nSmoothingSteps;
+  exercise_ = params.exercise;
+  adiScheme_ = params.adiScheme;
+  spatialScheme_ = params.spatialScheme;
+  nThreads_ = params.nThreads;
+  storageParams_ = params;
+  bool adaptive = params.timeStepTolerance > 0.0;
+  // the drifts of the 2nd order schemes, and of the adaptive steps that halve DT,
+  // are calibrated as for Crank-Nicolson
+  driftTheta_ = (scheme_ == PdeParams::Scheme::THETA && !adaptive) ? theta_ : 0.5;
+  ORF_ASSERT(!adaptive || scheme_ != PdeParams::Scheme::BDF2,
+    "PdeBase: the adaptive time stepping needs a one-step scheme!");
+  // get the time steps; the adaptive stepping starts from the product event times only
+  setTimeSteps(adaptive ? 1 : params.nTimeSteps);
   nSteps_ = timesteps_.size();
+  nStepsTaken_ = nStepsRejected_ = 0;
+  adaptiveDT_ = timesteps_.back() / std::max(params.nTimeSteps, size_t(1));
 
   // set the alignment values to the corresponding spots
   //alignments_ = spots_;
@@ -29,26 +46,11 @@ void PdeBase::solve(PdeParams const& params)
   // compute the conditional forward factors from step to step
   // the row index is the time, the column index is the asset
   Matrix fwdFactors(nSteps_, nAssets_);
-  for (size_t j = 0; j < nAssets_; ++j) {
-    SPtrYieldCurve spyc = spaccrycs_[j];
-    double divyld = divyields_[j];
-    for (size_t i = 0; i < nSteps_ - 1; ++i) {
-      double T1 = timesteps_[i];
-      double T2 = timesteps_[i + 1];
-      double fwdRate = spyc->fwdRate(T1, T2);
-      fwdFactors(i, j) = exp((fwdRate - divyld) * (T2 - T1));
-    }
-  }
-
-  // compute the forward vols from step to step
+  // and the forward vols from step to step
   Matrix fwdVols(nSteps_, nAssets_);
-  for (size_t j = 0; j < nAssets_; ++j) {
-    for (size_t i = 0; i < nSteps_ - 1; ++i) {
-      double T1 = timesteps_[i];
-      double T2 = timesteps_[i + 1];
-      fwdVols(i, j) = vols_[j]->fwdVol(T1, T2);
-    } 
-  }
+  for (size_t j = 0; j < nAssets_; ++j)
+    for (size_t i = 0; i < nSteps_ - 1; ++i)
+      stepFactors(j, timesteps_[i], timesteps_[i + 1], fwdFactors(i, j), fwdVols(i, j));
 
   // initialize the value layers (grid functions, one per variable to solve)
   initValLayers();
@@ -58,15 +60,22 @@ void PdeBase::solve(PdeParams const& params)
 
   // the main loop
   for (ptrdiff_t stepIdx = nSteps_ - 2; stepIdx >= 0; --stepIdx) {
-    updateGrid(params, fwdFactors, fwdVols, stepIdx);
+    if (adaptive) {
+      solveAdaptively(params, stepIdx);
+    }
+    else {
+      updateGrid(params, fwdFactors, fwdVols, stepIdx);
 
-    // solve
-    double dT = timesteps_[stepIdx + 1] - timesteps_[stepIdx];
-    solveFromStepToStep(stepIdx, dT);
+      // solve; the early exercise obstacle needs the discount rate
+      double dT = timesteps_[stepIdx + 1] - timesteps_[stepIdx];
+      double df = spdiscyc_->fwdDiscount(timesteps_[stepIdx], timesteps_[stepIdx + 1]);
+      discountRate_ = -std::log(df) / dT;
+      solveFromStepToStep(stepIdx, dT);
+      ++nStepsTaken_;
 
-    // discount
-    double df = spdiscyc_->fwdDiscount(timesteps_[stepIdx], timesteps_[stepIdx + 1]);
-    discountFromStepToStep(df);
+      // discount
+      discountFromStepToStep(df);
+    }
 
     // eval product for next iteration
     evalProduct(stepIdx);
@@ -74,12 +83,98 @@ void PdeBase::solve(PdeParams const& params)
   storeResults();
 }
 
+/** Solves from the time step stepIdx + 1 to stepIdx in sub-steps, sized so that the local
+    error of each sub-step, estimated by step doubling, stays within the tolerance.
+    The scaled difference of one step and two half steps estimates the error of the latter.
+    The error is controlled per step rather than per unit time, since the large errors of the
+    short steps after a payoff kink are damped by the later steps.
+*/
+void PdeBase::solveAdaptively(PdeParams const& params, ptrdiff_t stepIdx)
+{
+  double T1 = timesteps_[stepIdx];
+  double horizon = timesteps_.back();
+  double maxErr = params.timeStepTolerance;
+  double minDT = 1.0e-10 * horizon;
+
+  double t = timesteps_[stepIdx + 1];
+  while (t > T1) {
+    // take the rest of the interval if it is not much longer than the step
+    double DT = t - T1 < 1.1 * adaptiveDT_ ? t - T1 : adaptiveDT_;
+    std::vector<double> fwdFactors(nAssets_), fwdVols(nAssets_);
+    for (size_t j = 0; j < nAssets_; ++j) {
+      stepFactors(j, t - DT, t, fwdFactors[j], fwdVols[j]);
+      updateAxisCoefficients(j, DT, fwdFactors[j], fwdVols[j]);
+    }
+
+    double df = spdiscyc_->fwdDiscount(t - DT, t);
+    discountRate_ = -std::log(df) / DT;
+    // two half steps are more accurate than one step by 2^order - 1
+    double order = stepOrder();
+    double errScale = std::pow(2.0, order) - 1.0;
+    double err = trySolveFromStepToStep(stepIdx, DT, maxErr * errScale) / errScale;
+    if (err <= maxErr) {
+      discountFromStepToStep(df);
+      t = DT == t - T1 ? T1 : t - DT;
+      ++nStepsTaken_;
+    }
+    else {
+      ORF_ASSERT(DT > minDT, "PdeBase: the adaptive time step is too small!");
+      ++nStepsRejected_;
+    }
+    // grow or shrink the step so that the next error is just within the tolerance;
+    // the local error is of order order + 1
+    double factor = err > 0.0 ? 0.9 * std::pow(maxErr / err, 1.0 / (order + 1.0)) : 2.0;
+    adaptiveDT_ = DT * std::min(2.0, std::max(0.2, factor));
+  }
+}
+
+/** Computes the forward factor and the forward volatility of asset assetIdx from T1 to T2 */
+void PdeBase::stepFactors(size_t assetIdx, double T1, double T2, double& fwdFactor, double& fwdVol) const
+{
+  double fwdRate = spaccrycs_[assetIdx]->fwdRate(T1, T2);
+  fwdFactor = exp((fwdRate - divyields_[assetIdx]) * (T2 - T1));
+  fwdVol = vols_[assetIdx]->fwdVol(T1, T2);
+}
+
+/** Solves one adaptive step; implemented by the solvers that support adaptive time stepping */
+double PdeBase::trySolveFromStepToStep(ptrdiff_t, double, double)
+{
+  ORF_ASSERT(0, "PdeBase: this solver does not support adaptive time stepping!");
+  return 0.0;
+}
+
+/** The order of the time stepping scheme over the next step */
+double PdeBase::stepOrder() const
+{
+  return (scheme_ == PdeParams::Scheme::THETA && std::fabs(theta_ - 0.5) > 1.0e-12) ? 1.0 : 2.0;
+}
+
+/** Sets up the time steps from the product
+*/
+void PdeBase::setTimeSteps(size_t nsteps)
+{
+  if (enforcesExercise(*spprod_))
+    spprod_->timeStepsWithoutExercise(nsteps, timesteps_, stepindex_);
+  else
+    spprod_->timeSteps(nsteps, timesteps_, stepindex_);
+}
+
 /** Initializes the grid axes, sets up the nodes and the bounds
 */
 void PdeBase::initGrid(double T, PdeParams const& params)
 {
   ORF_ASSERT(nAssets_ == params.nSpotNodes.size(),
     "PdeBase: unequal number of assets and pde parameter axes specs!");
+  if (!fixedGridAxes_.empty()) {
+    ORF_ASSERT(fixedGridAxes_.size() == nAssets_, "PdeBase: unequal number of assets and grid axes!");
+    gridAxes_ = fixedGridAxes_;
+    for (size_t i = 0; i < nAssets_; ++i) {
+      ORF_ASSERT(gridAxes_[i].NX == params.nSpotNodes[i], "PdeBase: the grid axes do not match the pde parameters!");
+      gridAxes_[i].initFactors(spatialScheme_ == PdeParams::SpatialScheme::COMPACT);
+    }
+    return;
+  }
+
   // Resize the grid; the number of axes is equal to the number of equities in the product
   resize(nAssets_);
 
@@ -103,33 +198,97 @@ void PdeBase::initGrid(double T, PdeParams const& params)
     grax.coordinateChange->forwardAndVariance(forwardX, volX, T);
     grax.coordinateChange->bounds(X0, forwardX, volX, T, params.nStdDevs[i],
       grax.Xmin, grax.Xmax);
+
+    // end the axis at the knock-out levels within the bounds; no nodes are needed beyond them
+    grax.zeroAtXmin = grax.zeroAtXmax = false;
+    if (nAssets_ == 1) {
+      double lowKO, highKO;
+      knockOutLevels(lowKO, highKO);
+      if (lowKO > 0.0 && lowKO < S0) {
+        double Xb = grax.coordinateChange->fromRealToDiffused(lowKO);
+        if (Xb > grax.Xmin) {
+          grax.Xmin = Xb;
+          grax.zeroAtXmin = true;
+        }
+      }
+      if (highKO > S0 && highKO < HUGE_VAL) {
+        double Xb = grax.coordinateChange->fromRealToDiffused(highKO);
+        if (Xb < grax.Xmax) {
+          grax.Xmax = Xb;
+          grax.zeroAtXmax = true;
+        }
+      }
+    }
     grax.DX = (grax.Xmax - grax.Xmin) / (grax.NX + 1);
 
-    // align the grid axis so that a node passes through the alignment value
     double alignValue = grax.coordinateChange->fromRealToDiffused(alignments_[i]);
-    int X0NodeIdx = int(0.5 + (alignValue - grax.Xmin) / grax.DX);
-    double closestX = grax.Xmin + X0NodeIdx * grax.DX;
-    grax.Xmin -= closestX - alignValue;
-    grax.Xmax -= closestX - alignValue;
+    double concentration = i < params.nodeConcentration.size() ? params.nodeConcentration[i] : 0.0;
+    if (concentration > 0.0) {
+      // concentrate the nodes around the spot, the alignment value and the product critical points
+      std::vector<double> centers = { X0, alignValue };
+      if (nAssets_ == 1) {
+        std::vector<double> critical = spprod_->getCriticalPoints();
+        for (size_t k = 0; k < critical.size(); ++k) {
+          if (critical[k] <= 0.0)
+            continue;
+          double Xc = grax.coordinateChange->fromRealToDiffused(critical[k]);
+          if (Xc >= grax.Xmin && Xc <= grax.Xmax)
+            centers.push_back(Xc);
+        }
+      }
+      grax.concentrateNodes(centers, (grax.Xmax - grax.Xmin) / concentration, alignValue);
+    }
+    else if (grax.zeroAtXmin != grax.zeroAtXmax) {
+      // keep the knock-out end, and stretch the spacing so that a node passes through the alignment value;
+      // the spacing only grows, so that the far end never comes inside the bounds
+      double Xb = grax.zeroAtXmin ? grax.Xmin : grax.Xmax;
+      double nIntervals = std::floor(std::fabs(alignValue - Xb) / grax.DX);
+      if (nIntervals > 0.0)
+        grax.DX = std::fabs(alignValue - Xb) / nIntervals;
+      if (grax.zeroAtXmin)
+        grax.Xmax = grax.Xmin + (grax.NX + 1) * grax.DX;
+      else
+        grax.Xmin = grax.Xmax - (grax.NX + 1) * grax.DX;
+      grax.spacings.reset();
+      grax.Xlevels.resize(params.nSpotNodes[i] + 2);
+      for (size_t j = 0; j <= params.nSpotNodes[i] + 1; ++j)
+        grax.Xlevels[j] = grax.Xmin + j * grax.DX;
+      if (grax.zeroAtXmax)
+        grax.Xlevels[params.nSpotNodes[i] + 1] = grax.Xmax;   // exactly on the knock-out level
+    }
+    else if (grax.zeroAtXmin) {
+      // both ends are knock-out levels
+      grax.spacings.reset();
+      grax.Xlevels.resize(params.nSpotNodes[i] + 2);
+      for (size_t j = 0; j <= params.nSpotNodes[i] + 1; ++j)
+        grax.Xlevels[j] = grax.Xmin + j * grax.DX;
+      grax.Xlevels[params.nSpotNodes[i] + 1] = grax.Xmax;
+    }
+    else {
+      // align the grid axis so that a node passes through the alignment value
+      int X0NodeIdx = int(0.5 + (alignValue - grax.Xmin) / grax.DX);
+      double closestX = grax.Xmin + X0NodeIdx * grax.DX;
+      grax.Xmin -= closestX - alignValue;
+      grax.Xmax -= closestX - alignValue;
+      grax.spacings.reset();
+      grax.Xlevels.resize(params.nSpotNodes[i] + 2);  // add 2 for the boundary nodes
+      for (size_t j = 0; j <= params.nSpotNodes[i] + 1; ++j)
+        grax.Xlevels[j] = grax.Xmin + j * grax.DX;
+    }
 
-    // fill in the original and the transformed spot nodes
-    grax.Xlevels.resize(params.nSpotNodes[i] + 2);  // add 2 for the boundary nodes
+    // fill in the transformed spot nodes
     grax.Slevels.resize(params.nSpotNodes[i] + 2);
-    for (size_t j = 0; j <= params.nSpotNodes[i] + 1; ++j) {
-      grax.Xlevels[j] = grax.Xmin + j * grax.DX;
+    for (size_t j = 0; j <= params.nSpotNodes[i] + 1; ++j)
       grax.Slevels[j] = grax.coordinateChange->fromDiffusedToReal(grax.Xlevels[j]);
-    }
 
-    // resize the drift, variance and vol vectors
+    // resize the drift, variance and vol vectors and compute their node factors once
     // no need to add boundary points here
-    grax.drifts.resize(params.nSpotNodes[i]);
-    grax.variances.resize(params.nSpotNodes[i]);
-    grax.vols.resize(params.nSpotNodes[i]);
+    grax.initFactors(spatialScheme_ == PdeParams::SpatialScheme::COMPACT);
   }
 }
 
 /** Updates the grid axes for this time step index */
-void PdeBase::updateGrid(PdeParams const& params,
+void PdeBase::updateGrid(PdeParams const&,
                          Matrix const& fwdFactors,
                          Matrix const& fvols,
                          size_t stepIdx)
@@ -138,19 +297,18 @@ void PdeBase::updateGrid(PdeParams const& params,
   double T2 = timesteps_[stepIdx + 1];
   double DT = T2 - T1;
 
-  for (size_t assetIdx = 0; assetIdx < nAssets_; ++assetIdx) {
-    for (size_t j = 1; j <= params.nSpotNodes[assetIdx]; ++j) {
-      GridAxis& grax = gridAxes_[assetIdx];
-      double RealS = grax.Slevels[j];
-      double aCoeff = fwdFactors(stepIdx, assetIdx);
-      double RealF = RealS * aCoeff;
-      //changed for step localvol
-      double RealLNvol = fvols(stepIdx, assetIdx);
-      // set the drift, variance and vol values for this time step
-      grax.coordinateChange->driftAndVariance(RealS, RealF, theta_, DT, RealLNvol,
-        aCoeff, grax.DX, grax.drifts[j - 1], grax.variances[j - 1], grax.vols[j - 1]);
-    }
-  }
+  for (size_t assetIdx = 0; assetIdx < nAssets_; ++assetIdx)
+    updateAxisCoefficients(assetIdx, DT, fwdFactors(stepIdx, assetIdx), fvols(stepIdx, assetIdx));
+}
+
+/** Sets the drifts and variances of one grid axis for a step of size DT */
+void PdeBase::updateAxisCoefficients(size_t assetIdx,
+                                     double DT,
+                                     double aCoeff,
+                                     double RealLNvol)
+{
+  // one pass over the node factors computed in initGrid()
+  gridAxes_[assetIdx].setCoefficients(DT, aCoeff, driftTheta_, RealLNvol);
 }
 
 END_NAMESPACE(orf)
@@ -62,9 +62,16 @@ public:
   /** The entry point for the solver; this is the method that the client needs to call */
   void solve(PdeParams const& params);
 
+  /** Sets up the time steps and the step indices of the product events */
+  virtual void setTimeSteps(size_t nsteps);
+
   /** Initializes the grid axes, sets up the nodes and the bounds */
   virtual void initGrid(double T, PdeParams const& params);
 
+  /** Makes the solver use the passed-in grid axes, e.g. those of the results of an earlier solve,
+      instead of setting them up from the market data, so that bumped solves share the same grid */
+  void setGridAxes(std::vector<GridAxis> const& gridAxes) { fixedGridAxes_ = gridAxes; }
+
   /** Updates the drift and variance coefficients for the current time step */
   virtual void updateGrid(PdeParams const& params,
                           Matrix const& fwdFactors,
@@ -74,6 +81,20 @@ public:
   /** Solves backwards from one time step to the previous */
   virtual void solveFromStepToStep(ptrdiff_t step, double DT) = 0;
 
+  /** Solves backwards over DT, inside the interval ending at time step step + 1, with one step
+      and with two half steps, and returns the difference between the two solutions, as the root
+      mean square over the interior nodes of all layers; solveAdaptively() divides it by 2^order - 1
+      and compares it with the timeStepTolerance of the PdeParams.
+      It keeps the solution of the two half steps if the difference is at most maxDiff,
+      and restores the values before the step otherwise.
+      Used by the adaptive time stepping; the default implementation throws.
+  */
+  virtual double trySolveFromStepToStep(ptrdiff_t step, double DT, double maxDiff);
+
+  /** The order of the time stepping scheme over the next step, for the error estimate of the
+      adaptive time stepping; 1 for the THETA scheme with theta != 0.5, 2 otherwise */
+  virtual double stepOrder() const;
+
   /** Initializes the layers (grid functions) */
   virtual void initValLayers() = 0;
 
@@ -90,10 +111,34 @@ public:
   /** Aligns the grid to given vector */
   virtual void setAlignment() = 0;
 
+  /** Returns the knock-out levels at which the grid of a single asset may end, 0 and HUGE_VAL if none;
+      by default those of the product */
+  virtual void knockOutLevels(double& lower, double& upper) const
+  {
+    spprod_->getKnockOutLevels(lower, upper);
+  }
+
 protected:
   /** Default ctor */
   PdeBase() {}
 
+  /** Solves from time step stepIdx + 1 to stepIdx in adaptive sub-steps */
+  void solveAdaptively(PdeParams const& params, ptrdiff_t stepIdx);
+
+  /** Computes the forward factor and forward volatility of an asset from T1 to T2 */
+  void stepFactors(size_t assetIdx, double T1, double T2, double& fwdFactor, double& fwdVol) const;
+
+  /** Sets the drifts and variances of a grid axis for a step of size DT, with the forward factor
+      and forward volatility of the asset over the step */
+  void updateAxisCoefficients(size_t assetIdx, double DT, double aCoeff, double RealLNvol);
+
+  /** Returns true if the early exercise of the product is enforced at every time step,
+      rather than at its exercise fixings */
+  bool enforcesExercise(Product const& product) const
+  {
+    return exercise_ != PdeParams::Exercise::FIXINGS && product.hasEarlyExercise();
+  }
+
   /** Ctor from product; inherited classes must set the other market data */
   PdeBase(SPtrProduct product) : spprod_(product) {}
 
@@ -102,6 +147,18 @@ protected:
   size_t nAssets_;                    // number of assets to diffuse
   size_t nLayers_;                    // number of PDE variables being solved on the same grid
   double theta_;
+  double driftTheta_;                 // the theta the drifts are calibrated for
+  PdeParams::Scheme scheme_;          // the time stepping scheme
+  size_t nSmoothingSteps_;            // number of smoothed steps after maturity, for the Rannacher scheme
+  size_t nStepsTaken_;                // number of time steps taken, including the adaptive sub-steps
+  size_t nStepsRejected_;             // number of rejected adaptive sub-steps
+  double adaptiveDT_;                 // the next adaptive sub-step size
+  PdeParams::Exercise exercise_;      // the early exercise method
+  double discountRate_;               // the continuously compounded discount rate of the current step
+  PdeParams::AdiScheme adiScheme_;    // the time stepping scheme of the multi-dimensional solvers
+  PdeParams::SpatialScheme spatialScheme_; // the spatial differences of the 1-dim solver
+  size_t nThreads_;                   // threads for the line solves of the multi-dimensional solvers
+  PdeParams storageParams_;           // the parameters of the storage of all results
 
   SPtrProduct spprod_;                       // the product being priced
   SPtrYieldCurve spdiscyc_;                  // the discounting yield curve 
@@ -111,6 +168,7 @@ protected:
   std::vector<SPtrVolatilityTermStructure> vols_;  // the volatility term structure for each asset
 
   std::vector<GridAxis> gridAxes_;  // the grid axes
+  std::vector<GridAxis> fixedGridAxes_;  // the grid axes to use instead of setting them up, if any
   std::vector<double> spotAxis_;
   std::vector<double> alignments_;  // one value per axis at which a grid node must pass through
   std::vector<double> timesteps_;   // the vector of time steps
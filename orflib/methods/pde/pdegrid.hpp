@@ -10,6 +10,8 @@
 #include <orflib/math/matrix.hpp>
 #include <memory>
 #include <algorithm>
+#include <cmath>
+#include <vector>
 
 BEGIN_NAMESPACE(orf)
 
@@ -35,17 +37,6 @@ public:
 
   virtual void forwardAndVariance(double& fwd, double& vol, double T) = 0;
 
-  virtual void driftAndVariance(double realS,
-                                double realF,
-                                double theta,
-                                double DT,
-                                double realLNVol,
-                                double aCoeff,
-                                double DX,
-                                double& drift,
-                                double& variance,
-                                double& FinalVol) = 0;
-
   /** Computes the grid bounds Xmin and Xmax */
   virtual void bounds(double S0,
                       double fwd,
@@ -54,11 +45,93 @@ public:
                       double nstds,
                       double& Xmin,
                       double& Xmax) = 0;
+
+  /** Computes the factors of the drift and variance at the interior nodes 1..N of an axis with the
+      passed-in levels, spacing DX if uniform and spacings otherwise, so that for a step DT with the
+      forward factor aCoeff and the real log-volatility vol, the coefficients of the diffused equation are
+        drift = (aCoeff - 1) / ((theta aCoeff + 1 - theta) DT) driftFactor - 0.5 vol^2 convexityFactor
+        variance = (vol volFactor)^2
+      where driftFactor = S / Delta and convexityFactor = Gamma / Delta, Delta and Gamma being the discrete
+      first and second derivatives of the real spot S in the diffused coordinate.
+      If fourthOrder, Delta and Gamma are the five-point derivatives on a uniform axis, for the
+      compact differences, which need the coefficients of the continuous equation to O(DX^4).
+  */
+  virtual void axisFactors(Vector const& Xlevels, double DX, Vector const& spacings,
+                           Vector& driftFactors, Vector& convexityFactors, Vector& volFactors,
+                           bool fourthOrder = false)
+  {
+    computeAxisFactors(*this, Xlevels, DX, spacings, driftFactors, convexityFactors, volFactors,
+                       fourthOrder);
+  }
+
+  /** The volatility of the diffused coordinate per unit real log-volatility, at the real spot S
+      where the derivative of the real spot in the diffused coordinate is Delta */
+  virtual double volFactor(double S, double Delta)
+  {
+    return S / Delta;
+  }
+
+protected:
+
+  /** Implements axisFactors() for the coordinate change CC; its methods are called
+      without virtual dispatch if CC is final, see CoordinateChange */
+  template <typename CC>
+  static void computeAxisFactors(CC& cc, Vector const& Xlevels, double DX, Vector const& spacings,
+                                 Vector& driftFactors, Vector& convexityFactors, Vector& volFactors,
+                                 bool fourthOrder)
+  {
+    size_t n = Xlevels.size() - 2;
+    driftFactors.set_size(n);
+    convexityFactors.set_size(n);
+    volFactors.set_size(n);
+    bool uniform = spacings.is_empty();
+    for (size_t i = 1; i <= n; ++i) {
+      double Xi = Xlevels[i];
+      double Delta, Gamma, Si;
+      if (uniform) {
+        double Sm = cc.fromDiffusedToReal(Xi - DX), Sp = cc.fromDiffusedToReal(Xi + DX);
+        Si = cc.fromDiffusedToReal(Xi);
+        Delta = (Sp - Sm) / (2.0 * DX);
+        Gamma = (Sp - 2.0 * Si + Sm) / (DX * DX);
+        if (fourthOrder) {
+          double Smm = cc.fromDiffusedToReal(Xi - 2.0 * DX), Spp = cc.fromDiffusedToReal(Xi + 2.0 * DX);
+          Delta = (4.0 * Delta - (Spp - Smm) / (4.0 * DX)) / 3.0;
+          Gamma = (4.0 * Gamma - (Spp - 2.0 * Si + Smm) / (4.0 * DX * DX)) / 3.0;
+        }
+      }
+      else {
+        double hm = spacings[i - 1], hp = spacings[i], hs = hm + hp;
+        double Sm = cc.fromDiffusedToReal(Xi - hm), Sp = cc.fromDiffusedToReal(Xi + hp);
+        Si = cc.fromDiffusedToReal(Xi);
+        Delta = (-hp / (hm * hs)) * Sm + ((hp - hm) / (hm * hp)) * Si + (hm / (hp * hs)) * Sp;
+        Gamma = 2.0 * (Sm / (hm * hs) - Si / (hm * hp) + Sp / (hp * hs));
+      }
+      driftFactors[i - 1] = Si / Delta;
+      convexityFactors[i - 1] = Gamma / Delta;
+      volFactors[i - 1] = cc.volFactor(Si, Delta);
+    }
+  }
+};
+
+
+/** Implements axisFactors() for the final coordinate change CC, whose methods are then called
+    without virtual dispatch */
+template <typename CC>
+class CoordinateChange : public CoordinateChangeBase
+{
+public:
+  virtual void axisFactors(Vector const& Xlevels, double DX, Vector const& spacings,
+                           Vector& driftFactors, Vector& convexityFactors, Vector& volFactors,
+                           bool fourthOrder = false) override
+  {
+    computeAxisFactors(static_cast<CC&>(*this), Xlevels, DX, spacings, driftFactors, convexityFactors,
+                       volFactors, fourthOrder);
+  }
 };
 
 
 /** Identity coordinate change, i.e. Diffused = Real */
-class NoCoordinateChange : public CoordinateChangeBase
+class NoCoordinateChange final : public CoordinateChange<NoCoordinateChange>
 {
 public:
   virtual double fromRealToDiffused(double S)
@@ -71,29 +144,11 @@ public:
     return S;
   }
 
-  virtual void forwardAndVariance(double & fwd, double & vol, const double & T)
+  virtual void forwardAndVariance(double & fwd, double & vol, double T)
   {
     // nothing to do
   }
 
-  void driftAndVariance(double realS,
-                        double realF,
-                        double theta,
-                        double DT,
-                        double realLNVol,
-                        double aCoeff,
-                        double DX,
-                        double& drift,
-                        double& variance,
-                        double& finalVol)
-  {
-    double vol = realLNVol * realS;
-    double corr = (theta * aCoeff + 1 - theta);
-    drift = (realF - realS) / corr / DT;
-    variance = vol * vol;
-    finalVol = sqrt(variance);
-  }
-
   virtual void bounds(double S0,
                       double F,
                       double vol,
@@ -105,10 +160,16 @@ public:
     Xmin = std::min(S0, F) * exp(-0.5 * vol * vol * T - nstds * vol * sqrt(T));
     Xmax = std::max(S0, F) * exp(-0.5 * vol * vol * T + nstds * vol * sqrt(T));
   }
+
+  /** The diffused coordinate is the real spot, with the volatility vol S */
+  virtual double volFactor(double S, double)
+  {
+    return S;
+  }
 };
 
 /** Logarithmic coordinate change, i.e. Diffused = log(Real) */
-class LogCoordinateChange : public CoordinateChangeBase
+class LogCoordinateChange final : public CoordinateChange<LogCoordinateChange>
 {
 public:
 
@@ -139,25 +200,10 @@ public:
     Xmax = std::max(X0, F) + nstds * vol * sqrt(T);
   }
 
-  virtual void driftAndVariance(double realS,
-                                double realF,
-                                double theta,
-                                double DT,
-                                double realLNVol,
-                                double aCoeff,
-                                double DX,
-                                double& drift,
-                                double& variance,
-                                double& finalVol)
-  {
-    double Xi = fromRealToDiffused(realS);
-    double Deltaip1 = (fromDiffusedToReal(Xi + DX) - fromDiffusedToReal(Xi - DX)) / (2.0 * DX);
-    double Gammaip1 = (fromDiffusedToReal(Xi + DX) - 2 * fromDiffusedToReal(Xi) + fromDiffusedToReal(Xi - DX));
-    Gammaip1 /= (DX * DX);
-    double corr = (theta*aCoeff + 1 - theta);
-    drift = (realF - realS) / corr / DT / Deltaip1 - 0.5 * realLNVol * realLNVol * Gammaip1 / Deltaip1;
-    variance = realLNVol * realLNVol;
-    finalVol = realLNVol;
+  /** The log-spot has the real log-volatility */
+  virtual double volFactor(double, double)
+  {
+    return 1.0;
   }
 };
 
@@ -167,15 +213,18 @@ public:
 class GridAxis
 {
 public:
-  double Xmin, Xmax, DX;    // max, min and distance between nodes
+  double Xmin, Xmax, DX;    // max, min and distance between nodes (the average distance if non-uniform)
   size_t NX;                // number of interior nodes
   Vector Xlevels, Slevels;
+  Vector spacings;          // Xlevels[i+1] - Xlevels[i] for a non-uniform axis, empty if uniform
   Vector drifts, variances, vols;
+  Vector driftFactors, convexityFactors, volFactors;  // the node factors of the coefficients, see axisFactors()
   std::shared_ptr<CoordinateChangeBase> coordinateChange;  // the coordinate change rules for this axis
+  bool zeroAtXmin, zeroAtXmax;  // true if the axis ends at a knock-out level, where the values are zero
 
   /** Default ctor uses logarithmic coordinate changes */
   GridAxis()
-    : coordinateChange(new LogCoordinateChange())
+    : coordinateChange(new LogCoordinateChange()), zeroAtXmin(false), zeroAtXmax(false)
   {}
 
   /** Sets the coordinate changes */
@@ -183,8 +232,124 @@ public:
   {
     coordinateChange = c;
   }
+
+  /** Returns true if the nodes are equally spaced */
+  bool isUniform() const { return spacings.is_empty(); }
+
+  /** Sizes the coefficients and computes their node factors, once the levels are set;
+      fourthOrder for the compact differences, see CoordinateChangeBase::axisFactors() */
+  void initFactors(bool fourthOrder = false)
+  {
+    drifts.resize(NX);
+    variances.resize(NX);
+    vols.resize(NX);
+    coordinateChange->axisFactors(Xlevels, DX, spacings, driftFactors, convexityFactors, volFactors,
+                                  fourthOrder);
+  }
+
+  /** Sets the drifts, variances and vols of the interior nodes for a step DT with the forward factor
+      aCoeff and the real log-volatility vol, the drifts calibrated for the theta scheme with theta
+      so that the discrete operator reproduces the forward exactly */
+  void setCoefficients(double DT, double aCoeff, double theta, double vol)
+  {
+    double c = (aCoeff - 1.0) / ((theta * aCoeff + 1.0 - theta) * DT);
+    double h = 0.5 * vol * vol;
+    double const* df = driftFactors.memptr();
+    double const* cf = convexityFactors.memptr();
+    double const* vf = volFactors.memptr();
+    double* d = drifts.memptr();
+    double* var = variances.memptr();
+    double* v = vols.memptr();
+    for (size_t i = 0; i < NX; ++i) {
+      double vi = vol * vf[i];
+      d[i] = c * df[i] - h * cf[i];
+      var[i] = vi * vi;
+      v[i] = vi;
+    }
+  }
+
+  /** Same as above with a real log-volatility per interior node, e.g. a local volatility */
+  void setCoefficients(double DT, double aCoeff, double theta, Vector const& nodeVols)
+  {
+    double c = (aCoeff - 1.0) / ((theta * aCoeff + 1.0 - theta) * DT);
+    for (size_t i = 0; i < NX; ++i) {
+      double vi = nodeVols[i] * volFactors[i];
+      drifts[i] = c * driftFactors[i] - 0.5 * nodeVols[i] * nodeVols[i] * convexityFactors[i];
+      variances[i] = vi * vi;
+      vols[i] = vi;
+    }
+  }
+
+  /** Returns the distance between node i and its lower and upper neighbors */
+  double DXlow(size_t i) const { return isUniform() ? DX : spacings[i - 1]; }
+  double DXhigh(size_t i) const { return isUniform() ? DX : spacings[i]; }
+
+  /** Places the NX + 2 nodes in [Xmin, Xmax], concentrated around the centers.
+      The node density is proportional to sum_k 1 / sqrt(width^2 + (X - centers[k])^2),
+      i.e. the sinh mapping around each center, so that the nodes are placed at equal
+      increments of G(X) = sum_k asinh((X - centers[k]) / width).
+      The node closest to each center and to alignValue is then moved onto it.
+  */
+  void concentrateNodes(std::vector<double> const& centers, double width, double alignValue);
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline
+void GridAxis::concentrateNodes(std::vector<double> const& centers, double width, double alignValue)
+{
+  ORF_ASSERT(!centers.empty(), "GridAxis: no centers for the node concentration!");
+  ORF_ASSERT(width > 0.0, "GridAxis: the concentration width must be positive!");
+  auto G = [&](double x) {
+    double g = 0.0;
+    for (double c : centers)
+      g += std::asinh((x - c) / width);
+    return g;
+  };
+
+  size_t n = NX + 2;
+  Xlevels.set_size(n);
+  Xlevels[0] = Xmin;
+  Xlevels[n - 1] = Xmax;
+  double G0 = G(Xmin), G1 = G(Xmax);
+  for (size_t i = 1; i < n - 1; ++i) {
+    // G is increasing, invert it by bisection
+    double target = G0 + (G1 - G0) * i / (n - 1);
+    double lo = Xlevels[i - 1], hi = Xmax;
+    for (int it = 0; it < 100 && hi - lo > 1.0e-14 * (1.0 + std::fabs(hi)); ++it) {
+      double mid = 0.5 * (lo + hi);
+      (G(mid) < target ? lo : hi) = mid;
+    }
+    Xlevels[i] = 0.5 * (lo + hi);
+  }
+
+  // move the closest interior node onto each center, the alignment value first so that it wins;
+  // a center whose closest node is taken, or that would not stay between the neighbors, is skipped
+  std::vector<double> snaps(1, alignValue);
+  snaps.insert(snaps.end(), centers.begin(), centers.end());
+  std::vector<bool> taken(n, false);
+  for (double c : snaps) {
+    if (c <= Xmin || c >= Xmax)
+      continue;
+    size_t k = 1;
+    for (size_t i = 2; i < n - 1; ++i)
+      if (std::fabs(Xlevels[i] - c) < std::fabs(Xlevels[k] - c))
+        k = i;
+    if (taken[k] || c <= Xlevels[k - 1] || c >= Xlevels[k + 1])
+      continue;
+    Xlevels[k] = c;
+    taken[k] = true;
+  }
+
+  spacings.set_size(n - 1);
+  for (size_t i = 0; i < n - 1; ++i) {
+    spacings[i] = Xlevels[i + 1] - Xlevels[i];
+    ORF_ASSERT(spacings[i] > 0.0, "GridAxis: the concentrated nodes are not increasing!");
+  }
+  DX = (Xmax - Xmin) / (NX + 1);
+}
+
 END_NAMESPACE(orf)
 
 #endif  // #ifndef ORF_PDEGRID_HPP
@@ -6,6 +6,7 @@
 #ifndef ORF_PDEPARAMS_HPP
 #define ORF_PDEPARAMS_HPP
 
+#include <string>
 #include <vector>
 
 BEGIN_NAMESPACE(orf)
@@ -13,13 +14,82 @@ BEGIN_NAMESPACE(orf)
 struct PdeParams
 {
 public:
+  /** The time stepping schemes */
+  enum class Scheme
+  {
+    THETA,        // the theta scheme, with the theta below
+    RANNACHER,    // Crank-Nicolson, with the first nSmoothingSteps steps after maturity
+                  // split in two implicit half steps each
+    BDF2,         // the 2nd order backward differentiation formula, restarted with an implicit step
+                  // after each product event
+    TRBDF2        // a trapezoidal stage followed by a BDF2 stage in each step; 2nd order and L-stable
+  };
+
+  /** The methods for the early exercise of products that have it */
+  enum class Exercise
+  {
+    FIXINGS,          // the product takes the larger of continuation and exercise at its exercise fixings
+    BRENNAN_SCHWARTZ, // each implicit solve is projected on the exercise value during the substitution;
+                      // exact for a single exercise boundary, at the cost of a tridiagonal solve
+    PSOR,             // projected successive over-relaxation, for any exercise region
+    POLICY_ITERATION  // policy iteration on the exercise region, the limit of the penalty method
+                      // for an infinite penalty; for any exercise region
+  };
+
+  /** The alternating direction implicit schemes of the multi-dimensional solvers. Each step is
+      an explicit predictor followed by one implicit correction per dimension, with the mixed
+      derivative terms always explicit. */
+  enum class AdiScheme
+  {
+    DOUGLAS,            // one correction per dimension with theta = 1/2; 2nd order without correlation only
+    CRAIG_SNEYD,        // the modified Craig-Sneyd scheme, theta = 1/3; 2nd order with correlation
+    HUNDSDORFER_VERWER  // theta = 1/2 + sqrt(3)/6, 2nd order and better damping of the payoff kinks
+  };
+
+  /** The finite differences of the spatial derivatives of the 1-dim solver */
+  enum class SpatialScheme
+  {
+    CENTRAL,    // the 2nd order central differences
+    COMPACT     // the 4th order compact differences, still tridiagonal; for uniform nodes,
+                // the THETA and RANNACHER schemes and the FIXINGS exercise only
+  };
+
+  /** The precision of the values stored at the time steps, when the solver stores all results */
+  enum class StoragePrecision
+  {
+    DOUBLE,
+    FLOAT       // half the memory, with about 7 significant digits
+  };
+
   size_t nTimeSteps;
   std::vector<size_t> nSpotNodes; // spot nodes for each dimension
   std::vector<double> nStdDevs;   // num. standard deviations for each dimension
+  std::vector<double> nodeConcentration; // for each dimension, 0 for uniform nodes, otherwise the intensity
+                                         // of the concentration around the spot and the critical points
   double theta;
+  Scheme scheme;
+  size_t nSmoothingSteps;         // number of smoothed time steps after maturity, for the RANNACHER scheme
+  double timeStepTolerance;       // 0 for fixed time steps, otherwise the largest local error of an adaptive
+                                  // time step, in price units, as the root mean square over the interior nodes
+                                  // of all layers; nTimeSteps then sets the first step
+  Exercise exercise;              // the early exercise method
+  AdiScheme adiScheme;            // the time stepping scheme of the multi-dimensional solvers
+  SpatialScheme spatialScheme;    // the spatial differences of the 1-dim solver
+  size_t nThreads;                // threads for the line solves of the multi-dimensional solvers,
+                                  // 0 for as many as the hardware supports
+  std::vector<double> storeTimes; // the values are stored at the time steps nearest to these times,
+  size_t storeEvery;              // or if there are none, at every k-th time step from the first
+  StoragePrecision storagePrecision;
+  std::string storageFile;        // if not empty, the stored values are streamed to this memory-mapped file;
+                                  // each solve needs its own file
 
   /** Default ctor */
-  PdeParams(size_t n = 1) : nTimeSteps(1), nSpotNodes(n, 10), nStdDevs(n, 4.0), theta(0.0) {};
+  PdeParams(size_t n = 1)
+    : nTimeSteps(1), nSpotNodes(n, 10), nStdDevs(n, 4.0), nodeConcentration(n, 0.0), theta(0.0),
+      scheme(Scheme::THETA), nSmoothingSteps(2), timeStepTolerance(0.0),
+      exercise(Exercise::FIXINGS), adiScheme(AdiScheme::HUNDSDORFER_VERWER),
+      spatialScheme(SpatialScheme::CENTRAL), nThreads(0),
+      storeEvery(1), storagePrecision(StoragePrecision::DOUBLE) {};
 };
 
 
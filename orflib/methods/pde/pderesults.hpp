@@ -1,12 +1,15 @@
 /**
 @file  pderesults.hpp
-@brief Definition of the PdeResults and Pde1DResults classes
+@brief Definition of the PdeResults, Pde1DResults, Pde2DResults and Pde1DForwardResults classes
 */
 
 #ifndef ORF_PDERESULTS_HPP
 #define ORF_PDERESULTS_HPP
 
 #include <orflib/methods/pde/pdegrid.hpp>
+#include <orflib/methods/pde/pdestorage.hpp>
+#include <algorithm>
+#include <memory>
 #include <vector>
 
 BEGIN_NAMESPACE(orf)
@@ -16,17 +19,22 @@ class PdeResults
 public:
   Vector prices;      // vector of size nLayers, with the prices at the current spots
   Vector times;       // vector of time nodes
+  std::shared_ptr<PdeSliceStore> storedValues; // the values at the stored time steps, if the solver
+                                               // stores all results; shared by the copies of the results
   std::vector<GridAxis> gridAxes; // vector of size nAssets with the grid axes
+  size_t nTimeSteps;      // number of time steps taken
+  size_t nRejectedSteps;  // number of time steps rejected by the adaptive time stepping
+
+  /** Default ctor */
+  PdeResults() : nTimeSteps(0), nRejectedSteps(0) {}
 
   /** Computes the spot axis for the asset with index assetIdx */
   void getSpotAxis(size_t assetIdx, Vector& axis)
   {
     ORF_ASSERT(!gridAxes.empty(), "No grid axes info. in PDE results!");
     axis.resize(gridAxes[assetIdx].NX + 2);
-    double xmin = gridAxes[assetIdx].Xmin;
-    double dx = gridAxes[assetIdx].DX;
     for (size_t i = 0; i < axis.size(); ++i) {
-      axis[i] = gridAxes[assetIdx].coordinateChange->fromDiffusedToReal(xmin + i * dx);
+      axis[i] = gridAxes[assetIdx].coordinateChange->fromDiffusedToReal(gridAxes[assetIdx].Xlevels[i]);
     }
   }
 
@@ -54,25 +62,122 @@ protected:
 class Pde1DResults : public PdeResults
 {
 public:
-  std::vector<Matrix> values; // for each time a nSpots x nLayers matrix of values
+  Matrix finalValues;         // the nSpots x nLayers matrix of values at the first time
+  Matrix nextValues;          // the values one time step later, for the theta
+  Matrix nextValues2;         // the values two time steps later
+  double nextDT;              // the time from the first time to nextValues
+  double nextDT2;             // the time from nextValues to nextValues2; 0 if a product event
+                              // between them makes them unusable for the theta
+
+  /** Default ctor */
+  Pde1DResults() : nextDT(0.0), nextDT2(0.0) {}
+
+  /** Returns the vector of the stored times, the vector of spots and, for each stored time,
+      a view of the values at the spots of the variable with index varIdx.
+      The views point into the stored values and are valid as long as these results or their copies.
+  */
+  void getValues(size_t varIdx, Vector& timeAxis, Vector& xAxis, std::vector<PdeSliceView>& zValues)
+  {
+    ORF_ASSERT(storedValues, "Pde1DResults: no stored values!");
+    timeAxis = storedValues->times();
+    getSpotAxis(0, xAxis);
+    zValues.resize(storedValues->size());
+    for (size_t i = 0; i < zValues.size(); ++i)
+      zValues[i] = storedValues->slice(i).col(varIdx);
+  }
 
-  /** Returns the vector of times, the vector of spots and the matrix of values for
-      a variable with index varIdx
+  /** Computes the price, delta, gamma and theta of the variable with index varIdx at each of the
+      passed-in spots, from the values at the first time and one time step later, so that no
+      bumped solves are needed. The derivatives are those of the cubic through the four spot nodes
+      nearest to each spot; the theta is the change in value per unit time at a fixed spot,
+      the derivative of the quadratic through the values at the first three times when available.
+      Each row of greeks is for one spot, with the columns price, delta, gamma and theta.
   */
-  void getValues(int varIdx, Vector& timeAxis, Vector& xAxis, Matrix& zValues)
+  void getGreeks(size_t varIdx, Vector const& spots, Matrix& greeks)
   {
-    timeAxis = times;
+    ORF_ASSERT(finalValues.n_rows > 3, "Pde1DResults: no final values for the Greeks!");
+    ORF_ASSERT(varIdx < finalValues.n_cols, "Pde1DResults: variable index out of range!");
+    Vector xAxis;
     getSpotAxis(0, xAxis);
-    zValues.resize(times.size(), xAxis.size());
+    size_t n = xAxis.size();
+    greeks.zeros(spots.size(), 4);
+    for (size_t s = 0; s < spots.size(); ++s) {
+      double S = spots[s];
+      ORF_ASSERT(S >= xAxis[0] && S <= xAxis[n - 1], "Pde1DResults: spot outside of the grid!");
+      // the four nodes around S, shifted inwards at the edges
+      size_t k = std::upper_bound(xAxis.begin(), xAxis.end(), S) - xAxis.begin();
+      k = std::min(std::max(k, size_t(2)), n - 2) - 2;
+      double w[3][4];
+      cubicWeights(xAxis.memptr() + k, S, w);
+      double next = 0.0, next2 = 0.0;
+      for (size_t m = 0; m < 4; ++m) {
+        for (size_t d = 0; d < 3; ++d)
+          greeks(s, d) += w[d][m] * finalValues(k + m, varIdx);
+        if (nextDT > 0.0)
+          next += w[0][m] * nextValues(k + m, varIdx);
+        if (nextDT2 > 0.0)
+          next2 += w[0][m] * nextValues2(k + m, varIdx);
+      }
+      double h1 = nextDT, h2 = nextDT2;
+      if (h2 > 0.0)
+        greeks(s, 3) = -(2.0 * h1 + h2) / (h1 * (h1 + h2)) * greeks(s, 0)
+                     + (h1 + h2) / (h1 * h2) * next - h1 / (h2 * (h1 + h2)) * next2;
+      else if (h1 > 0.0)
+        greeks(s, 3) = (next - greeks(s, 0)) / h1;
+    }
+  }
 
-    for (size_t i = 0; i < times.size(); ++i) {
-      for (size_t j = 0; j < xAxis.size(); ++j) {
-        zValues(i, j) = values[i](j, varIdx);
+private:
+  // the weights of the values at the nodes x[0..3] in the value, first and second derivative
+  // at x0 of the cubic through them
+  static void cubicWeights(double const* x, double x0, double w[3][4])
+  {
+    for (size_t m = 0; m < 4; ++m) {
+      double d[3], denom = 1.0;
+      for (size_t a = 0, b = 0; a < 4; ++a) {
+        if (a == m)
+          continue;
+        d[b++] = x0 - x[a];
+        denom *= x[m] - x[a];
       }
+      w[0][m] = d[0] * d[1] * d[2] / denom;
+      w[1][m] = (d[1] * d[2] + d[0] * d[2] + d[0] * d[1]) / denom;
+      w[2][m] = 2.0 * (d[0] + d[1] + d[2]) / denom;
     }
   }
 };
 
+
+class Pde2DResults : public PdeResults
+{
+public:
+  /** Returns the vector of the stored times and, for each stored time, a view of the nSpots1 x nSpots2
+      matrix of values, the rows for the first asset and the columns for the second.
+      The views point into the stored values and are valid as long as these results or their copies.
+  */
+  void getValues(Vector& timeAxis, std::vector<PdeSliceView>& zValues)
+  {
+    ORF_ASSERT(storedValues, "Pde2DResults: no stored values!");
+    timeAxis = storedValues->times();
+    zValues.resize(storedValues->size());
+    for (size_t i = 0; i < zValues.size(); ++i)
+      zValues[i] = storedValues->slice(i);
+  }
+};
+
+
+/** The results of the forward pde solver: the call prices for all maturities and strikes.
+    The put prices follow by the put-call parity, P = C - S0 e^{-qT} + K e^{-rT}.
+*/
+class Pde1DForwardResults : public PdeResults
+{
+public:
+  Vector maturities;   // the maturities, increasing
+  Vector strikes;      // the strikes
+  Matrix callPrices;   // the nMaturities x nStrikes matrix of call prices
+  Matrix gridValues;   // the nStrikeNodes x nMaturities matrix of call prices at the nodes of the strike axis
+};
+
 END_NAMESPACE(orf)
 
 
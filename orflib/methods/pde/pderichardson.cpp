@@ -0,0 +1,95 @@
+/**
+@file  pderichardson.cpp
+@brief Implementation of the Richardson extrapolation of 1-dim PDE prices
+*/
+
+#include <orflib/methods/pde/pderichardson.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+BEGIN_NAMESPACE(orf)
+
+PdeRichardsonResults solvePde1DRichardson(Pde1DJob const& job,
+                                          size_t nLevels,
+                                          PdeRefinement refinement,
+                                          size_t nThreads)
+{
+  ORF_ASSERT(nLevels >= 2, "solvePde1DRichardson: at least two levels are needed!");
+  ORF_ASSERT(job.params.nSpotNodes.size() == 1, "solvePde1DRichardson: the job must have one spot axis!");
+  bool refineSpace = refinement != PdeRefinement::TIME;
+  bool refineTime = refinement != PdeRefinement::SPACE;
+
+  // the jobs of the successive levels
+  PdeRichardsonResults res;
+  std::vector<Pde1DJob> jobs(nLevels, job);
+  for (size_t k = 0; k < nLevels; ++k) {
+    // the levels are solved concurrently, each streams its stored values to its own file
+    if (!job.params.storageFile.empty())
+      jobs[k].params.storageFile = job.params.storageFile + "." + std::to_string(k);
+  }
+  for (size_t k = 1; k < nLevels; ++k) {
+    PdeParams& params = jobs[k].params;
+    PdeParams const& prev = jobs[k - 1].params;
+    if (refineSpace)
+      params.nSpotNodes[0] = 2 * prev.nSpotNodes[0] + 1;
+    if (refineTime)
+      params.nTimeSteps = 2 * prev.nTimeSteps;
+  }
+  for (size_t k = 0; k < nLevels; ++k)
+    res.levelParams.push_back(jobs[k].params);
+  res.levels = solvePde1DStrip(jobs, nThreads);
+
+  // the leading power of the error and the step to the next ones, in time from the scheme as in
+  // PdeBase::solveAdaptively(); Crank-Nicolson and the central differences expand in even powers only,
+  // the compact differences from the fourth power on
+  PdeParams const& params = job.params;
+  double timePower = 2.0, timeStep = 2.0;
+  if (params.scheme == PdeParams::Scheme::THETA && std::fabs(params.theta - 0.5) > 1.0e-12)
+    timePower = timeStep = 1.0;
+  else if (params.scheme == PdeParams::Scheme::BDF2 || params.scheme == PdeParams::Scheme::TRBDF2)
+    timeStep = 1.0;
+  double spacePower = params.spatialScheme == PdeParams::SpatialScheme::COMPACT ? 4.0 : 2.0, spaceStep = 2.0;
+  double power = refineTime ? timePower : spacePower;
+  double step = refineTime ? timeStep : spaceStep;
+  if (refineTime && refineSpace) {
+    power = std::min(timePower, spacePower);
+    step = std::min(timeStep, spaceStep);
+  }
+
+  size_t nLayers = res.levels[0].prices.size();
+  res.prices.resize(nLayers);
+  res.errors.resize(nLayers);
+  res.orders.resize(nLayers);
+  for (size_t l = 0; l < nLayers; ++l) {
+    // the Richardson tableau, overwritten row by row; T[j] eliminates the first j powers
+    std::vector<double> T(nLevels);
+    double prevDiag = 0.0;
+    for (size_t k = 0; k < nLevels; ++k) {
+      double prevT = res.levels[k].prices[l];
+      std::swap(prevT, T[0]);
+      for (size_t j = 1; j <= k; ++j) {
+        double factor = std::pow(2.0, power + (j - 1) * step) - 1.0;
+        double Tj = T[j - 1] + (T[j - 1] - prevT) / factor;
+        prevT = T[j];
+        T[j] = Tj;
+      }
+      if (k + 1 == nLevels)
+        prevDiag = T[k - 1];
+    }
+    res.prices[l] = T[nLevels - 1];
+    res.errors[l] = std::fabs(T[nLevels - 1] - prevDiag);
+
+    res.orders[l] = std::numeric_limits<double>::quiet_NaN();
+    if (nLevels >= 3) {
+      double d1 = res.levels[nLevels - 2].prices[l] - res.levels[nLevels - 3].prices[l];
+      double d2 = res.levels[nLevels - 1].prices[l] - res.levels[nLevels - 2].prices[l];
+      if (d1 != 0.0 && d2 != 0.0)
+        res.orders[l] = std::log2(std::fabs(d1 / d2));
+    }
+  }
+  return res;
+}
+
+END_NAMESPACE(orf)
@@ -0,0 +1,57 @@
+/**
+@file  pderichardson.hpp
+@brief Richardson extrapolation of 1-dim PDE prices over successively refined grids
+*/
+
+#ifndef ORF_PDERICHARDSON_HPP
+#define ORF_PDERICHARDSON_HPP
+
+#include <orflib/methods/pde/pde1dstrip.hpp>
+#include <vector>
+
+BEGIN_NAMESPACE(orf)
+
+/** The grid dimensions halved from one Richardson level to the next */
+enum class PdeRefinement
+{
+  SPACE,            // the spacing of the spot nodes
+  TIME,             // the time step
+  SPACE_AND_TIME    // both, keeping their ratio fixed
+};
+
+/** The results of a Richardson extrapolation */
+struct PdeRichardsonResults
+{
+  Vector prices;                        // the extrapolated prices, one per layer
+  Vector errors;                        // the error estimates of the extrapolated prices, one per layer
+  Vector orders;                        // the observed convergence orders of the three finest levels, one per layer;
+                                        // NaN with two levels or when the prices do not change
+  std::vector<PdeParams> levelParams;   // the PDE parameters of each level, from the coarsest to the finest
+  std::vector<Pde1DResults> levels;     // the results of each level, from the coarsest to the finest
+};
+
+/** Solves the job on nLevels grids, halving the spacing of the dimensions in refinement
+    from one level to the next, and extrapolates the prices to zero spacing.
+    The job parameters define the coarsest level; a level with NX interior spot nodes
+    is followed by one with 2 NX + 1, so that the node spacing is exactly halved,
+    and one with M time steps by one with 2 M.
+    The error is assumed to expand in powers of the spacing h, h^2, h^3, ... for the THETA
+    scheme with theta != 0.5 refined in time, h^2, h^3, ... for BDF2 and TRBDF2 refined in time,
+    and h^2, h^4, ... otherwise (Crank-Nicolson, RANNACHER, and the spot spacing), from h^4 on for the spot
+    spacing of the COMPACT differences. Refined together, the lowest power and the smallest step apply.
+    Each extra level eliminates the next power. The error estimate is the size of the
+    last correction, and the observed orders tell whether the assumed expansion holds.
+    It does not when the payoff kinks fall between nodes; a nodeConcentration > 0 puts
+    them on nodes at every level. Early exercise also spoils the expansion.
+    The levels are solved concurrently on up to nThreads threads,
+    as many as the hardware supports if nThreads is 0.
+    If the job has a storageFile, level k streams its stored values to storageFile.k instead.
+*/
+PdeRichardsonResults solvePde1DRichardson(Pde1DJob const& job,
+                                          size_t nLevels = 3,
+                                          PdeRefinement refinement = PdeRefinement::SPACE_AND_TIME,
+                                          size_t nThreads = 0);
+
+END_NAMESPACE(orf)
+
+#endif  // #ifndef ORF_PDERICHARDSON_HPP
@@ -0,0 +1,143 @@
+/**
+@file  pdestorage.cpp
+@brief Implementation of the storage of the values of a PDE solve at its time steps
+*/
+
+#include <orflib/methods/pde/pdestorage.hpp>
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+BEGIN_NAMESPACE(orf)
+
+void MappedFile::open(std::string const& fileName, size_t size)
+{
+  close();
+  ORF_ASSERT(size > 0, "MappedFile: cannot map an empty file!");
+#ifdef _WIN32
+  HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  ORF_ASSERT(file != INVALID_HANDLE_VALUE, "MappedFile: cannot create the file " + fileName + "!");
+  unsigned long long nbytes = size;
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+                                      DWORD(nbytes >> 32), DWORD(nbytes & 0xFFFFFFFFull), NULL);
+  if (mapping == NULL) {
+    CloseHandle(file);
+    ORF_ASSERT(0, "MappedFile: cannot map the file " + fileName + "!");
+  }
+  void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (data == NULL) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    ORF_ASSERT(0, "MappedFile: cannot map the file " + fileName + "!");
+  }
+  file_ = reinterpret_cast<std::intptr_t>(file);
+  mapping_ = reinterpret_cast<std::intptr_t>(mapping);
+#else
+  int fd = ::open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ORF_ASSERT(fd >= 0, "MappedFile: cannot create the file " + fileName + "!");
+  void* data = MAP_FAILED;
+  if (::ftruncate(fd, off_t(size)) == 0)
+    data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    ::close(fd);
+    ORF_ASSERT(0, "MappedFile: cannot map the file " + fileName + "!");
+  }
+  file_ = fd;
+#endif
+  data_ = static_cast<char*>(data);
+  size_ = size;
+}
+
+void MappedFile::close()
+{
+  if (!data_)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile(data_);
+  CloseHandle(reinterpret_cast<HANDLE>(mapping_));
+  CloseHandle(reinterpret_cast<HANDLE>(file_));
+#else
+  ::munmap(data_, size_);
+  ::close(int(file_));
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  file_ = mapping_ = -1;
+}
+
+
+PdeSliceStore::PdeSliceStore(std::vector<double> const& timesteps, size_t nRows, size_t nCols,
+                             PdeParams const& params)
+: nRows_(nRows), nCols_(nCols), data_(nullptr)
+{
+  ORF_ASSERT(params.storeEvery > 0, "PdeSliceStore: storeEvery must be positive!");
+  isFloat_ = params.storagePrecision == PdeParams::StoragePrecision::FLOAT;
+  elemSize_ = isFloat_ ? sizeof(float) : sizeof(double);
+
+  // select the time steps; the ones nearest to the requested times, or every k-th one
+  std::vector<char> selected(timesteps.size(), 0);
+  if (params.storeTimes.empty()) {
+    for (size_t i = 0; i < timesteps.size(); i += params.storeEvery)
+      selected[i] = 1;
+  }
+  else {
+    for (double t : params.storeTimes) {
+      size_t i = std::lower_bound(timesteps.begin(), timesteps.end(), t) - timesteps.begin();
+      if (i == timesteps.size() || (i > 0 && t - timesteps[i - 1] < timesteps[i] - t))
+        --i;
+      selected[i] = 1;
+    }
+  }
+  slot_.assign(timesteps.size(), -1);
+  std::vector<double> times;
+  for (size_t i = 0; i < timesteps.size(); ++i) {
+    if (!selected[i])
+      continue;
+    slot_[i] = ptrdiff_t(times.size());
+    times.push_back(timesteps[i]);
+  }
+  times_.resize(times.size());
+  std::copy(times.begin(), times.end(), times_.begin());
+
+  size_t nbytes = times.size() * nRows_ * nCols_ * elemSize_;
+  if (nbytes == 0)
+    return;
+  if (params.storageFile.empty()) {
+    memory_.resize(nbytes);
+    data_ = memory_.data();
+  }
+  else {
+    file_.open(params.storageFile, nbytes);
+    data_ = file_.data();
+  }
+}
+
+void PdeSliceStore::store(size_t stepIdx, Matrix const& values)
+{
+  ptrdiff_t slot = slot_[stepIdx];
+  if (slot < 0)
+    return;
+  ORF_ASSERT(values.n_rows == nRows_ && values.n_cols == nCols_, "PdeSliceStore: wrong slice size!");
+  size_t n = nRows_ * nCols_;
+  char* p = data_ + slot * n * elemSize_;
+  if (isFloat_) {
+    float* f = reinterpret_cast<float*>(p);
+    double const* v = values.memptr();
+    for (size_t k = 0; k < n; ++k)
+      f[k] = float(v[k]);
+  }
+  else
+    std::memcpy(p, values.memptr(), n * sizeof(double));
+}
+
+END_NAMESPACE(orf)
@@ -0,0 +1,136 @@
+/**
+@file  pdestorage.hpp
+@brief Definition of the storage of the values of a PDE solve at its time steps
+*/
+
+#ifndef ORF_PDESTORAGE_HPP
+#define ORF_PDESTORAGE_HPP
+
+#include <orflib/exception.hpp>
+#include <orflib/math/matrix.hpp>
+#include <orflib/methods/pde/pdeparams.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+BEGIN_NAMESPACE(orf)
+
+/** A read-only view of a matrix of values stored in double or float precision, column-wise.
+    It does not own the values and is valid as long as the storage it points into.
+*/
+class PdeSliceView
+{
+public:
+  size_t n_rows;
+  size_t n_cols;
+
+  /** Default ctor, an empty view */
+  PdeSliceView() : n_rows(0), n_cols(0), dvals_(nullptr), fvals_(nullptr) {}
+
+  /** Ctor from double values */
+  PdeSliceView(double const* vals, size_t nrows, size_t ncols)
+  : n_rows(nrows), n_cols(ncols), dvals_(vals), fvals_(nullptr) {}
+
+  /** Ctor from float values */
+  PdeSliceView(float const* vals, size_t nrows, size_t ncols)
+  : n_rows(nrows), n_cols(ncols), dvals_(nullptr), fvals_(vals) {}
+
+  /** The value at row i and column j */
+  double operator()(size_t i, size_t j = 0) const
+  {
+    size_t k = i + j * n_rows;
+    return dvals_ ? dvals_[k] : double(fvals_[k]);
+  }
+
+  /** The view of column j */
+  PdeSliceView col(size_t j) const
+  {
+    ORF_ASSERT(j < n_cols, "PdeSliceView: column index out of range!");
+    return dvals_ ? PdeSliceView(dvals_ + j * n_rows, n_rows, 1)
+                  : PdeSliceView(fvals_ + j * n_rows, n_rows, 1);
+  }
+
+private:
+  double const* dvals_;
+  float const* fvals_;
+};
+
+
+/** A file of a given size mapped read-write into memory. The file is created or truncated on opening
+    and left on disk on closing.
+*/
+class MappedFile
+{
+public:
+  /** Default ctor, nothing mapped */
+  MappedFile() : data_(nullptr), size_(0), file_(-1), mapping_(-1) {}
+
+  /** Dtor, unmaps the file */
+  ~MappedFile() { close(); }
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+
+  /** Creates the file with the given number of bytes and maps it */
+  void open(std::string const& fileName, size_t size);
+
+  /** Unmaps and closes the file */
+  void close();
+
+  /** The start of the mapped bytes */
+  char* data() const { return data_; }
+
+private:
+  char* data_;
+  size_t size_;
+  std::intptr_t file_;      // the platform handles of the file and of its mapping
+  std::intptr_t mapping_;
+};
+
+
+/** The values of a PDE solve at the time steps selected by the storage parameters of the PdeParams,
+    one slice of nRows x nCols values per stored time step. The slices are kept in memory, in double
+    or float precision, or streamed as they are produced to a memory-mapped file, so that the memory
+    in use stays bounded by what the operating system keeps paged in.
+*/
+class PdeSliceStore
+{
+public:
+  /** Ctor from the time steps of the solve, the size of each slice and the storage parameters */
+  PdeSliceStore(std::vector<double> const& timesteps, size_t nRows, size_t nCols, PdeParams const& params);
+
+  PdeSliceStore(PdeSliceStore const&) = delete;
+  PdeSliceStore& operator=(PdeSliceStore const&) = delete;
+
+  /** Stores the values at the time step stepIdx, if it is selected; otherwise does nothing */
+  void store(size_t stepIdx, Matrix const& values);
+
+  /** The number of stored slices */
+  size_t size() const { return times_.size(); }
+
+  /** The times of the stored slices, ascending */
+  Vector const& times() const { return times_; }
+
+  /** The view of the slice with index i, for the time times()[i] */
+  PdeSliceView slice(size_t i) const
+  {
+    ORF_ASSERT(i < size(), "PdeSliceStore: slice index out of range!");
+    char const* p = data_ + i * nRows_ * nCols_ * elemSize_;
+    return isFloat_ ? PdeSliceView(reinterpret_cast<float const*>(p), nRows_, nCols_)
+                    : PdeSliceView(reinterpret_cast<double const*>(p), nRows_, nCols_);
+  }
+
+private:
+  std::vector<ptrdiff_t> slot_;   // for each time step, the index of its slice, -1 if not stored
+  Vector times_;
+  size_t nRows_, nCols_;
+  bool isFloat_;
+  size_t elemSize_;               // the bytes of each value
+  std::vector<char> memory_;      // the slices, one after the other, when kept in memory
+  MappedFile file_;               // or in the file
+  char* data_;                    // the start of the first slice
+};
+
+END_NAMESPACE(orf)
+
+#endif  // #ifndef ORF_PDESTORAGE_HPP
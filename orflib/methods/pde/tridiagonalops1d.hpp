@@ -10,6 +10,8 @@
 #include <orflib/exception.hpp>
 #include <orflib/math/matrix.hpp>
 #include <algorithm>
+#include <cmath>
+#include <vector>
 
 BEGIN_NAMESPACE(orf)
 
@@ -29,6 +31,66 @@ void solveTridiagonal(ARRAY2& x,
                       ARRAY1	const& upper,
                       ARRAY2	const& y);
 
+/** Caller-owned workspace for the tridiagonal solvers.
+    It is resized on demand and reused across calls, so that repeated solves
+    on the same grid do not allocate. Each thread must use its own workspace.
+*/
+struct TridiagonalWorkspace
+{
+  Vector D, Y;             // the eliminated diagonal and right-hand side
+  Matrix DK, YK;           // the same for the batched solver, one row per system
+};
+
+/** Reentrant version of solveTridiagonal, using the passed-in workspace.
+    Same conventions as solveTridiagonal above.
+*/
+template <typename ARRAY1, typename ARRAY2>
+void solveTridiagonal(ARRAY2& x,
+                      ARRAY1 const& lower,
+                      ARRAY1 const& diag,
+                      ARRAY1 const& upper,
+                      ARRAY2 const& y,
+                      TridiagonalWorkspace& work);
+
+/** Solves K independent tridiagonal systems of the same size N at once.
+    All arguments are K x N matrices, one row per system, so that in the column-major
+    storage the K values at each node are contiguous and the inner loop over
+    the systems maps to SIMD lanes.
+    Same conventions as solveTridiagonal: the first and last columns are ignored and
+    only the columns 1 ... N-2 of x are modified.
+*/
+void solveTridiagonalBatch(Matrix& x,
+                           Matrix const& lower,
+                           Matrix const& diag,
+                           Matrix const& upper,
+                           Matrix const& y,
+                           TridiagonalWorkspace& work);
+
+/** Solves K tridiagonal systems that share the same matrix, e.g. the same operator
+    applied to many payoffs. The matrix is input as three vectors of size N,
+    the right-hand sides and solutions as K x N matrices, one row per system.
+*/
+template <typename ARRAY1>
+void solveTridiagonalBatch(Matrix& x,
+                           ARRAY1 const& lower,
+                           ARRAY1 const& diag,
+                           ARRAY1 const& upper,
+                           Matrix const& y,
+                           TridiagonalWorkspace& work);
+
+/** Same as above for the systems in the rows k0 ... k1-1 only; the other rows of x are not modified.
+    Threads with their own workspaces may solve disjoint row ranges of the same matrices.
+*/
+template <typename ARRAY1>
+void solveTridiagonalBatch(Matrix& x,
+                           ARRAY1 const& lower,
+                           ARRAY1 const& diag,
+                           ARRAY1 const& upper,
+                           Matrix const& y,
+                           size_t k0,
+                           size_t k1,
+                           TridiagonalWorkspace& work);
+
 /** Utility function that adjusts the explicit and implicit operators for boundary conditions.
     The adjustment implements constant first derivative in spot space at the edge nodes
     (zero second derivative in spot space)
@@ -49,16 +111,68 @@ void adjustOpsForBoundaryConditions(EXPOP& opExplicit,
   opExplicit.addToUpperVal(-highAdjustmentValueImp + highAdjustmentValueExp);
 }
 
+/** Same as above for a non-uniform grid with the passed-in node spacings (size N+1).
+    The edge values are extrapolated with constant first derivative in spot space,
+    using the spacings of the two edge intervals at each end.
+*/
+template <typename EXPOP, typename IMPOP>
+void adjustOpsForBoundaryConditions(EXPOP& opExplicit,
+                                    IMPOP& opImplicit,
+                                    Vector const& spacings)
+{
+  adjustOpForBoundaryConditions(opImplicit, spacings);
+  adjustOpForBoundaryConditions(opExplicit, spacings);
+}
 
-/** Adjusts the solution at the edge notes */
+/** Adjusts a single operator for the same boundary conditions,
+    e.g. the implicit operator of a step without an explicit part.
+    If zeroLow or zeroHigh is true, the value at that edge node is zero instead (a knock-out).
+*/
+template <typename OP>
+void adjustOpForBoundaryConditions(OP& op, double DX, bool zeroLow = false, bool zeroHigh = false)
+{
+  op.adjustForLowerBoundaryCondition(zeroLow ? 0 : 3, 0.0, DX, 0.0, 0.0);
+  op.adjustForHigherBoundaryCondition(zeroHigh ? 0 : 3, 0.0, DX, 0.0, 0.0);
+}
+
+/** Same as above for a non-uniform grid with the passed-in node spacings (size N+1) */
+template <typename OP>
+void adjustOpForBoundaryConditions(OP& op, Vector const& spacings, bool zeroLow = false, bool zeroHigh = false)
+{
+  size_t n = spacings.size();
+  double h0 = spacings[0], h1 = spacings[1];
+  double hn = spacings[n - 1], hn1 = spacings[n - 2];
+  // v0 = v1 - r (v2 - v1) and v(N+1) = vN + q (vN - v(N-1)), r and q to second order in the spacings
+  double r = h0 * (1.0 - h0 / 2.0) / (h1 * (1.0 + h1 / 2.0));
+  double q = hn * (1.0 + hn / 2.0) / (hn1 * (1.0 - hn1 / 2.0));
+  op.adjustForLowerBoundaryCondition(zeroLow ? 0 : 4, 0.0, h0, 1.0 + r, -r);
+  op.adjustForHigherBoundaryCondition(zeroHigh ? 0 : 4, 0.0, hn, 1.0 + q, -q);
+}
+
+
+/** Adjusts the solution at the edge notes; zeroLow and zeroHigh set the edge values to zero instead */
 inline
-void applyBoundaryConditions(Matrix& solution)
+void applyBoundaryConditions(Matrix& solution, bool zeroLow = false, bool zeroHigh = false)
 {
   size_t n = solution.n_rows - 2;    // n is the number of interior nodes
   size_t nLayers = solution.n_cols;  // number of layers is the number of variables
   for (size_t j = 0; j < nLayers; ++j) {
-    solution(0, j) = 2.0 * solution(1, j) - solution(2, j);
-    solution(n + 1, j) = 2.0 * solution(n, j) - solution(n - 1, j);
+    solution(0, j) = zeroLow ? 0.0 : 2.0 * solution(1, j) - solution(2, j);
+    solution(n + 1, j) = zeroHigh ? 0.0 : 2.0 * solution(n, j) - solution(n - 1, j);
+  }
+}
+
+/** Adjusts the solution at the edge nodes of a non-uniform grid, with the passed-in node spacings */
+inline
+void applyBoundaryConditions(Matrix& solution, Vector const& spacings, bool zeroLow = false, bool zeroHigh = false)
+{
+  size_t n = solution.n_rows - 2;    // n is the number of interior nodes
+  size_t nLayers = solution.n_cols;  // number of layers is the number of variables
+  double r = spacings[0] / spacings[1];
+  double q = spacings[n] / spacings[n - 1];
+  for (size_t j = 0; j < nLayers; ++j) {
+    solution(0, j) = zeroLow ? 0.0 : solution(1, j) + r * (solution(1, j) - solution(2, j));
+    solution(n + 1, j) = zeroHigh ? 0.0 : solution(n, j) + q * (solution(n, j) - solution(n - 1, j));
   }
 }
 
@@ -71,7 +185,7 @@ class TridiagonalOp1D
 public:
 
   /** default ctor */
-  TridiagonalOp1D() : N_(0), LowerVal_(0.0), UpperVal_(0.0) {}
+  TridiagonalOp1D() : N_(0), factorized_(false), LowerVal_(0.0), UpperVal_(0.0) {}
 
   /** initializing ctor from the three diagonal vectors*/
   TridiagonalOp1D(ARRAY const& lower, ARRAY const& diag, ARRAY const& upper)
@@ -90,6 +204,7 @@ public:
   {
     N_ = lower_.size() - 2;
     LowerVal_ = UpperVal_ = 0.0;
+    factorized_ = false;
   }
 
   /** Initializing function */
@@ -100,6 +215,7 @@ public:
     upper_ = upper;
     N_ = lower_.size() - 2;
     LowerVal_ = UpperVal_ = 0.0;
+    factorized_ = false;
   }
 
   /** Initializing function */
@@ -107,6 +223,7 @@ public:
   {
     N_ = N;
     LowerVal_ = UpperVal_ = 0.0;
+    factorized_ = false;
     lower_.resize(N + 2);
     std::fill(lower_.begin(), lower_.end(), lowerConst);
     diag_.resize(N + 2);
@@ -115,6 +232,83 @@ public:
     std::fill(upper_.begin(), upper_.end(), upperConst);
   }
 
+  /** Initializes the operator to I + coeff * (Delta + Gamma) in a single pass, where Delta and Gamma
+      are the central difference operators of DeltaOp1D and GammaOp1D with theta = 1.
+      It is equivalent to initializing to the identity and adding coeff times DeltaOp1D and GammaOp1D.
+  */
+  template <typename ARRAY2>
+  void initConvectionDiffusion(ARRAY2 const& drifts, ARRAY2 const& variances,
+                               double DT, double DX, double coeff)
+  {
+    size_t N = drifts.size();
+    init(N, 0.0, 1.0, 0.0);
+    double fd = coeff * DT / (2.0 * DX);
+    double fv = coeff * 0.5 * DT / DX / DX;
+    for (size_t i = 1; i <= N; ++i) {
+      double d = drifts[i - 1] * fd;
+      double v = variances[i - 1] * fv;
+      lower_[i] = v - d;
+      diag_[i] = 1.0 - 2.0 * v;
+      upper_[i] = v + d;
+    }
+  }
+
+  /** Same as above for a non-uniform grid with the passed-in node spacings (size N+1),
+      using the three-point first and second derivatives on unequal intervals.
+  */
+  template <typename ARRAY2>
+  void initConvectionDiffusion(ARRAY2 const& drifts, ARRAY2 const& variances,
+                               double DT, Vector const& spacings, double coeff)
+  {
+    size_t N = drifts.size();
+    init(N, 0.0, 1.0, 0.0);
+    for (size_t i = 1; i <= N; ++i) {
+      double hm = spacings[i - 1], hp = spacings[i], hs = hm + hp;
+      double d = coeff * DT * drifts[i - 1];
+      double v = coeff * DT * variances[i - 1];     // 0.5 * variance * 2 / ...
+      lower_[i] = (v - d * hp) / (hm * hs);
+      diag_[i] = 1.0 + d * (hp - hm) / (hm * hp) - v / (hm * hp);
+      upper_[i] = (v + d * hm) / (hp * hs);
+    }
+  }
+
+  /** Initializes the operator to A + coeff * DT * B, the 4th order compact differences of
+        L = 0.5 variance d2/dX2 + drift d/dX
+      on a uniform grid. For constant coefficients B V = A L V + O(DX^4) at the interior nodes, with
+        A = I + DX^2 / 12 (D2 + drift / (0.5 variance) D1)
+        B = (0.5 variance + DX^2 drift^2 / (6 variance)) D2 + drift D1
+      where D1 and D2 are the central differences of DeltaOp1D and GammaOp1D. Both are tridiagonal, so the
+      theta step (I - theta DT L) V(t) = (I + (1 - theta) DT L) V(t + DT), multiplied by A, becomes
+        (A - theta DT B) V(t) = (A + (1 - theta) DT B) V(t + DT)
+      with the operators initialized with coeff = -theta and 1 - theta; with theta = 1 the right-hand
+      side operator is A itself. The edge values enter the first and last rows as for the central
+      differences, so adjustOpForBoundaryConditions applies unchanged.
+      The nodes without variance keep the central differences.
+  */
+  template <typename ARRAY2>
+  void initCompactConvectionDiffusion(ARRAY2 const& drifts, ARRAY2 const& variances,
+                                      double DT, double DX, double coeff)
+  {
+    size_t N = drifts.size();
+    init(N, 0.0, 1.0, 0.0);
+    double f = coeff * DT / (DX * DX);
+    for (size_t i = 1; i <= N; ++i) {
+      double drift = drifts[i - 1], var = variances[i - 1];
+      double a = 0.5 * var, d = 0.5 * DX * drift;
+      double lo = 0.0, di = 1.0, up = 0.0;    // the row of A
+      if (var > 0.0) {
+        double m = DX * drift / (12.0 * var);  // DX^2 / 12 drift / (0.5 variance) / (2 DX)
+        a += DX * DX * drift * drift / (6.0 * var);
+        lo = 1.0 / 12.0 - m;
+        di = 5.0 / 6.0;
+        up = 1.0 / 12.0 + m;
+      }
+      lower_[i] = lo + f * (a - d);
+      diag_[i] = di - 2.0 * f * a;
+      upper_[i] = up + f * (a + d);
+    }
+  }
+
   /** Adds to the lower value */
   void addToLowerVal(double lowerVal) { LowerVal_ += lowerVal; }
 
@@ -130,13 +324,14 @@ public:
     adjustForHigherBoundaryCondition(3, 0.0, DX, 0.0, 0.0);
   }
 
-  /** Lower boundary conditions */
+  /** Lower boundary conditions. Returns the term that the edge value adds to the first row,
+      to be moved to the right-hand side; degree 0 sets the edge value to value. */
   double adjustForLowerBoundaryCondition(int degree,
                                          double value,
                                          double DX,
                                          double diagAdjust,
                                          double upAdjust);
-  /** Higher boundary conditions */
+  /** Higher boundary conditions, same as above for the last row */
   double adjustForHigherBoundaryCondition(int degree,
                                           double value,
                                           double DX,
@@ -164,10 +359,96 @@ public:
     result[N_] += lower_[N_] * vals[N_ - 1] + diag_[N_] * vals[N_] + UpperVal_;
   }
 
+  /** Applies the operator to K grid functions at once, stored as the rows k0 ... k1-1 of vals */
+  void applyBatch(Matrix const& vals, Matrix& result, size_t k0, size_t k1) const
+  {
+    for (size_t i = 1; i <= N_; ++i) {
+      double lo = i > 1 ? lower_[i] : 0.0;
+      double up = i < N_ ? upper_[i] : 0.0;
+      double c = (i == 1 ? LowerVal_ : 0.0) + (i == N_ ? UpperVal_ : 0.0);
+      double const* vm = vals.colptr(i - 1) + k0;
+      double const* vi = vals.colptr(i) + k0;
+      double const* vp = vals.colptr(i + 1) + k0;
+      double* ri = result.colptr(i) + k0;
+      for (size_t k = 0; k < k1 - k0; ++k)
+        ri[k] = c + lo * vm[k] + diag_[i] * vi[k] + up * vp[k];
+    }
+  }
+
+  /** Applies the operator to every column (layer) of vals */
+  void applyToLayers(Matrix const& vals, Matrix& result) const
+  {
+    for (size_t j = 0; j < vals.n_cols; ++j) {
+      double* res = result.colptr(j);
+      apply(vals.colptr(j), res);
+    }
+  }
+
+  /** Solves for every column (layer) of vals, with a single factorization */
+  void applyInverseToLayers(Matrix const& vals, Matrix& result)
+  {
+    for (size_t j = 0; j < vals.n_cols; ++j) {
+      double* res = result.colptr(j);
+      applyInverse(vals.colptr(j), res);
+    }
+  }
+
+  /** Solves this * result = vals. The LU factorization is computed on the first call
+      and reused until the operator is modified. */
   template <typename ARRAY1, typename ARRAY2>
-  void applyInverse(ARRAY1 const& vals, ARRAY2& result)
+  void applyInverse(ARRAY1 const& vals, ARRAY2& result);
+
+  /** Computes and caches the LU factorization used by applyInverse */
+  void factorize();
+
+  // Linear complementarity problems, for early exercise. They find the result with
+  // this * result >= vals and result >= obstacle, with equality in one of the two at each node.
+
+  /** Solves the linear complementarity problem by the method of Brennan and Schwartz:
+      the substitution starts at the exercise end of the grid and projects each value on the obstacle.
+      It is exact if the exercise region is an interval at the low end of the grid (exerciseBelow,
+      as for a put) or at the high end (as for a call), at the cost of one tridiagonal solve.
+  */
+  template <typename ARRAY1, typename ARRAY2, typename ARRAY3>
+  void applyInverseBrennanSchwartz(ARRAY1 const& vals, ARRAY3 const& obstacle, ARRAY2& result,
+                                   bool exerciseBelow);
+
+  /** Solves the linear complementarity problem by projected successive over-relaxation,
+      starting from the values in result, for any exercise region. An omega of 0 selects
+      the optimal relaxation of the system without obstacle.
+      Returns the number of iterations; throws if the residual is still above tol,
+      relative to the largest value, after maxIter iterations.
+  */
+  template <typename ARRAY1, typename ARRAY2, typename ARRAY3>
+  size_t applyInversePSOR(ARRAY1 const& vals, ARRAY3 const& obstacle, ARRAY2& result,
+                          double omega, double tol, size_t maxIter);
+
+  /** Solves the linear complementarity problem by policy iteration, for any exercise region.
+      Each iteration solves the system with result = obstacle in the current exercise region,
+      then moves to the exercise region the nodes below the obstacle and out of it the nodes
+      where the value would grow faster than the operator allows. It stops when the region
+      no longer changes, usually after two or three iterations from the values in result.
+      Returns the number of iterations; throws if it does not stop after maxIter iterations.
+  */
+  template <typename ARRAY1, typename ARRAY2, typename ARRAY3>
+  size_t applyInversePolicyIteration(ARRAY1 const& vals, ARRAY3 const& obstacle, ARRAY2& result,
+                                     size_t maxIter);
+
+  /** Returns true if the cached LU factorization is up to date */
+  bool isFactorized() const { return factorized_; }
+
+  /** Applies the inverse to K grid functions at once, stored as the rows of vals */
+  void applyInverseBatch(Matrix const& vals, Matrix& result)
   {
-    solveTridiagonal(result, lower_, diag_, upper_, vals);
+    solveTridiagonalBatch(result, lower_, diag_, upper_, vals, work_);
+  }
+
+  /** Same as above for the rows k0 ... k1-1 of vals only, with the passed-in workspace,
+      so that threads may solve disjoint row ranges with the same operator */
+  void applyInverseBatch(Matrix const& vals, Matrix& result, size_t k0, size_t k1,
+                         TridiagonalWorkspace& work) const
+  {
+    solveTridiagonalBatch(result, lower_, diag_, upper_, vals, k0, k1, work);
   }
 
 
@@ -240,9 +521,13 @@ public:
 protected:
   size_t N_;
   ARRAY lower_, diag_, upper_; // all of them have size N_+2
+  Vector invD_, ratio_;        // the LU factorization: inverse pivots and elimination ratios
+  bool factorized_;            // true if invD_ and ratio_ match the current coefficients
 
 private:
   double LowerVal_, UpperVal_;
+  TridiagonalWorkspace work_;  // owned by the operator, so that operators can be used concurrently
+  std::vector<char> exercised_; // the exercise region of the policy iteration
 };
 
 /** The identity operator */
@@ -282,6 +567,24 @@ public:
     }
     TridiagonalOp1D<ARRAY>::init();
   }
+
+  /** Initializes for a non-uniform grid with the passed-in node spacings (size N+1) */
+  template <class ARRAY2>
+  void init(ARRAY2 const & drifts, double DT, Vector const& spacings, double theta)
+  {
+    size_t N = drifts.size();
+    TridiagonalOp1D<ARRAY>::lower_.resize(N + 2);
+    TridiagonalOp1D<ARRAY>::diag_.resize(N + 2);
+    TridiagonalOp1D<ARRAY>::upper_.resize(N + 2);
+    for (size_t i = 1; i <= N; ++i) {
+      double hm = spacings[i - 1], hp = spacings[i];
+      double temp = drifts[i - 1] * DT * theta / (hm + hp);
+      TridiagonalOp1D<ARRAY>::lower_[i] = -temp * hp / hm;
+      TridiagonalOp1D<ARRAY>::diag_[i] = temp * (hp - hm) * (hm + hp) / (hm * hp);
+      TridiagonalOp1D<ARRAY>::upper_[i] = temp * hm / hp;
+    }
+    TridiagonalOp1D<ARRAY>::init();
+  }
 };
 
 /** The Gamma Operator */
@@ -313,6 +616,24 @@ public:
     }
     TridiagonalOp1D<ARRAY>::init();
   }
+
+  /** Initializes for a non-uniform grid with the passed-in node spacings (size N+1) */
+  template <typename ARRAY2>
+  void init(ARRAY2 const & variances, double DT, Vector const& spacings, double theta)
+  {
+    size_t N = variances.size();
+    TridiagonalOp1D<ARRAY>::lower_.resize(N + 2);
+    TridiagonalOp1D<ARRAY>::diag_.resize(N + 2);
+    TridiagonalOp1D<ARRAY>::upper_.resize(N + 2);
+    for (size_t i = 1; i <= N; ++i) {
+      double hm = spacings[i - 1], hp = spacings[i];
+      double temp = DT * theta * variances[i - 1] / (hm + hp);
+      TridiagonalOp1D<ARRAY>::lower_[i] = temp / hm;
+      TridiagonalOp1D<ARRAY>::upper_[i] = temp / hp;
+      TridiagonalOp1D<ARRAY>::diag_[i] = -temp * (hm + hp) / (hm * hp);
+    }
+    TridiagonalOp1D<ARRAY>::init();
+  }
 };
 
 
@@ -326,16 +647,26 @@ void solveTridiagonal(ARRAY2& x,
                       ARRAY1 const& upper,
                       ARRAY2 const& y)
 {
-  ptrdiff_t i, n = diag.size() - 2;
+  TridiagonalWorkspace work;
+  solveTridiagonal(x, lower, diag, upper, y, work);
+}
 
-  static Vector D(1);
-  static Vector Y(1);
+template <typename ARRAY1, typename ARRAY2> inline
+void solveTridiagonal(ARRAY2& x,
+                      ARRAY1 const& lower,
+                      ARRAY1 const& diag,
+                      ARRAY1 const& upper,
+                      ARRAY2 const& y,
+                      TridiagonalWorkspace& work)
+{
+  ptrdiff_t i, n = diag.size() - 2;
 
+  Vector& D = work.D;
+  Vector& Y = work.Y;
   if (D.size() != n + 1)
-    D = Vector(n + 1);
-
+    D.set_size(n + 1);
   if (Y.size() != n + 1)
-    Y = Vector(n + 1);
+    Y.set_size(n + 1);
 
   D[n] = diag[n];
   Y[n] = y[n];
@@ -352,6 +683,335 @@ void solveTridiagonal(ARRAY2& x,
   }
 }
 
+inline
+void solveTridiagonalBatch(Matrix& x,
+                           Matrix const& lower,
+                           Matrix const& diag,
+                           Matrix const& upper,
+                           Matrix const& y,
+                           TridiagonalWorkspace& work)
+{
+  size_t K = diag.n_rows;
+  ptrdiff_t i, n = diag.n_cols - 2;
+  ORF_ASSERT(n >= 1, "solveTridiagonalBatch: grid is too small!");
+  ORF_ASSERT(x.n_rows == K && x.n_cols == diag.n_cols, "solveTridiagonalBatch: solution has the wrong size!");
+
+  Matrix& D = work.DK;
+  Matrix& Y = work.YK;
+  if (D.n_rows != K || D.n_cols != size_t(n + 1))
+    D.set_size(K, n + 1);
+  if (Y.n_rows != K || Y.n_cols != size_t(n + 1))
+    Y.set_size(K, n + 1);
+
+  for (size_t k = 0; k < K; ++k) {
+    D(k, n) = diag(k, n);
+    Y(k, n) = y(k, n);
+  }
+
+  for (i = n - 1; i >= 1; i--) {
+    double const* lo = lower.colptr(i + 1);
+    double const* di = diag.colptr(i);
+    double const* up = upper.colptr(i);
+    double const* yi = y.colptr(i);
+    double const* D1 = D.colptr(i + 1);
+    double const* Y1 = Y.colptr(i + 1);
+    double* Di = D.colptr(i);
+    double* Yi = Y.colptr(i);
+    for (size_t k = 0; k < K; ++k) {
+      double r = up[k] / D1[k];
+      Di[k] = di[k] - r * lo[k];
+      Yi[k] = yi[k] - r * Y1[k];
+    }
+  }
+
+  for (size_t k = 0; k < K; ++k)
+    x(k, 1) = Y(k, 1) / D(k, 1);
+
+  for (i = 2; i <= n; i++) {
+    double const* lo = lower.colptr(i);
+    double const* Di = D.colptr(i);
+    double const* Yi = Y.colptr(i);
+    double const* x0 = x.colptr(i - 1);
+    double* xi = x.colptr(i);
+    for (size_t k = 0; k < K; ++k)
+      xi[k] = (Yi[k] - lo[k] * x0[k]) / Di[k];
+  }
+}
+
+template <typename ARRAY1> inline
+void solveTridiagonalBatch(Matrix& x,
+                           ARRAY1 const& lower,
+                           ARRAY1 const& diag,
+                           ARRAY1 const& upper,
+                           Matrix const& y,
+                           TridiagonalWorkspace& work)
+{
+  solveTridiagonalBatch(x, lower, diag, upper, y, 0, y.n_rows, work);
+}
+
+template <typename ARRAY1> inline
+void solveTridiagonalBatch(Matrix& x,
+                           ARRAY1 const& lower,
+                           ARRAY1 const& diag,
+                           ARRAY1 const& upper,
+                           Matrix const& y,
+                           size_t k0,
+                           size_t k1,
+                           TridiagonalWorkspace& work)
+{
+  size_t K = k1 - k0;
+  ptrdiff_t i, n = diag.size() - 2;
+  ORF_ASSERT(n >= 1, "solveTridiagonalBatch: grid is too small!");
+  ORF_ASSERT(x.n_rows == y.n_rows && x.n_cols == size_t(n + 2), "solveTridiagonalBatch: solution has the wrong size!");
+  ORF_ASSERT(k0 <= k1 && k1 <= y.n_rows, "solveTridiagonalBatch: row range out of bounds!");
+
+  // the eliminated diagonal is the same for all systems
+  Vector& D = work.D;
+  Matrix& Y = work.YK;
+  if (D.size() != size_t(n + 1))
+    D.set_size(n + 1);
+  if (Y.n_rows != K || Y.n_cols != size_t(n + 1))
+    Y.set_size(K, n + 1);
+
+  D[n] = diag[n];
+  for (size_t k = 0; k < K; ++k)
+    Y(k, n) = y(k0 + k, n);
+
+  for (i = n - 1; i >= 1; i--) {
+    double r = upper[i] / D[i + 1];
+    D[i] = diag[i] - r * lower[i + 1];
+    double const* yi = y.colptr(i) + k0;
+    double const* Y1 = Y.colptr(i + 1);
+    double* Yi = Y.colptr(i);
+    for (size_t k = 0; k < K; ++k)
+      Yi[k] = yi[k] - r * Y1[k];
+  }
+
+  double inv = 1.0 / D[1];
+  for (size_t k = 0; k < K; ++k)
+    x(k0 + k, 1) = Y(k, 1) * inv;
+
+  for (i = 2; i <= n; i++) {
+    double lo = lower[i];
+    inv = 1.0 / D[i];
+    double const* Yi = Y.colptr(i);
+    double const* x0 = x.colptr(i - 1) + k0;
+    double* xi = x.colptr(i) + k0;
+    for (size_t k = 0; k < K; ++k)
+      xi[k] = (Yi[k] - lo * x0[k]) * inv;
+  }
+}
+
+template<typename ARRAY>
+inline
+void TridiagonalOp1D<ARRAY>::factorize()
+{
+  // same backward elimination as solveTridiagonal, storing the pivots and ratios
+  ptrdiff_t i, n = N_;
+  invD_.set_size(n + 1);
+  ratio_.set_size(n + 1);
+  double D = diag_[n];
+  invD_[n] = 1.0 / D;
+  for (i = n - 1; i >= 1; i--) {
+    ratio_[i] = upper_[i] * invD_[i + 1];
+    D = diag_[i] - ratio_[i] * lower_[i + 1];
+    invD_[i] = 1.0 / D;
+  }
+  factorized_ = true;
+}
+
+template<typename ARRAY>
+template<typename ARRAY1, typename ARRAY2>
+inline
+void TridiagonalOp1D<ARRAY>::applyInverse(ARRAY1 const& vals, ARRAY2& result)
+{
+  if (!factorized_)
+    factorize();
+  ptrdiff_t i, n = N_;
+  Vector& Y = work_.Y;
+  if (Y.size() != size_t(n + 1))
+    Y.set_size(n + 1);
+
+  Y[n] = vals[n];
+  for (i = n - 1; i >= 1; i--)
+    Y[i] = vals[i] - ratio_[i] * Y[i + 1];
+
+  result[1] = Y[1] * invD_[1];
+  for (i = 2; i <= n; i++)
+    result[i] = (Y[i] - lower_[i] * result[i - 1]) * invD_[i];
+}
+
+template<typename ARRAY>
+template<typename ARRAY1, typename ARRAY2, typename ARRAY3>
+inline
+void TridiagonalOp1D<ARRAY>::applyInverseBrennanSchwartz(ARRAY1 const& vals,
+                                                         ARRAY3 const& obstacle,
+                                                         ARRAY2& result,
+                                                         bool exerciseBelow)
+{
+  ptrdiff_t i, n = N_;
+  Vector& Y = work_.Y;
+  if (Y.size() != size_t(n + 1))
+    Y.set_size(n + 1);
+
+  if (exerciseBelow) {
+    // the cached factorization eliminates from the high end, so the substitution starts at the low end
+    if (!factorized_)
+      factorize();
+    Y[n] = vals[n];
+    for (i = n - 1; i >= 1; i--)
+      Y[i] = vals[i] - ratio_[i] * Y[i + 1];
+
+    result[1] = std::max(Y[1] * invD_[1], double(obstacle[1]));
+    for (i = 2; i <= n; i++)
+      result[i] = std::max((Y[i] - lower_[i] * result[i - 1]) * invD_[i], double(obstacle[i]));
+  }
+  else {
+    // eliminate from the low end, and substitute from the high end
+    Vector& D = work_.D;
+    if (D.size() != size_t(n + 1))
+      D.set_size(n + 1);
+    D[1] = diag_[1];
+    Y[1] = vals[1];
+    for (i = 2; i <= n; i++) {
+      double r = lower_[i] / D[i - 1];
+      D[i] = diag_[i] - r * upper_[i - 1];
+      Y[i] = vals[i] - r * Y[i - 1];
+    }
+
+    result[n] = std::max(Y[n] / D[n], double(obstacle[n]));
+    for (i = n - 1; i >= 1; i--)
+      result[i] = std::max((Y[i] - upper_[i] * result[i + 1]) / D[i], double(obstacle[i]));
+  }
+}
+
+template<typename ARRAY>
+template<typename ARRAY1, typename ARRAY2, typename ARRAY3>
+inline
+size_t TridiagonalOp1D<ARRAY>::applyInversePSOR(ARRAY1 const& vals,
+                                                ARRAY3 const& obstacle,
+                                                ARRAY2& result,
+                                                double omega,
+                                                double tol,
+                                                size_t maxIter)
+{
+  size_t n = N_;
+  if (omega <= 0.0) {
+    // the optimal relaxation of a tridiagonal system, from the spectral radius of the Jacobi
+    // iteration of a constant coefficient operator like the interior rows
+    double rho = 0.0;
+    for (size_t i = 2; i + 1 < n; ++i)
+      rho = std::max(rho, (std::fabs(lower_[i]) + std::fabs(upper_[i])) / std::fabs(diag_[i]));
+    rho = std::min(rho * std::cos(3.141592653589793 / (n + 1)), 1.0);
+    omega = 2.0 / (1.0 + std::sqrt(1.0 - rho * rho));
+  }
+  for (size_t iter = 1; iter <= maxIter; ++iter) {
+    // the operator is an M-matrix with unit diagonal dominance, so the residual
+    // of the complementarity problem bounds the error
+    double maxResidual = 0.0, maxValue = 1.0;
+    for (size_t i = 1; i <= n; ++i) {
+      // the first row does not couple to the edge node, which the boundary condition eliminated
+      double rhs = vals[i];
+      if (i > 1)
+        rhs -= lower_[i] * result[i - 1];
+      if (i < n)
+        rhs -= upper_[i] * result[i + 1];
+      double residual = std::min(diag_[i] * result[i] - rhs, result[i] - obstacle[i]);
+      maxResidual = std::max(maxResidual, std::fabs(residual));
+      if (i + 1 < n) {
+        double x = result[i] + omega * (rhs / diag_[i] - result[i]);
+        result[i] = std::max(x, double(obstacle[i]));
+      }
+      else if (i == n) {
+        // the last row, folded by the boundary condition, is not diagonally dominant for
+        // large steps, so the last two nodes are solved together
+        double r1 = vals[n - 1] - lower_[n - 1] * result[n - 2];
+        double det = diag_[n - 1] * diag_[n] - upper_[n - 1] * lower_[n];
+        double x1 = (r1 * diag_[n] - upper_[n - 1] * vals[n]) / det;
+        double x2 = (diag_[n - 1] * vals[n] - lower_[n] * r1) / det;
+        // a node below its obstacle is fixed on it, and the other one solves its own row
+        if (x2 < obstacle[n]) {
+          x2 = obstacle[n];
+          x1 = std::max((r1 - upper_[n - 1] * x2) / diag_[n - 1], double(obstacle[n - 1]));
+        }
+        else if (x1 < obstacle[n - 1]) {
+          x1 = obstacle[n - 1];
+          x2 = std::max((vals[n] - lower_[n] * x1) / diag_[n], double(obstacle[n]));
+        }
+        result[n - 1] = x1;
+        result[n] = x2;
+        maxValue = std::max(maxValue, std::fabs(result[n - 1]));
+      }
+      maxValue = std::max(maxValue, std::fabs(result[i]));
+    }
+    if (maxResidual <= tol * maxValue)
+      return iter;
+  }
+  ORF_ASSERT(0, "TridiagonalOperator1D: projected SOR did not converge!");
+  return maxIter;
+}
+
+template<typename ARRAY>
+template<typename ARRAY1, typename ARRAY2, typename ARRAY3>
+inline
+size_t TridiagonalOp1D<ARRAY>::applyInversePolicyIteration(ARRAY1 const& vals,
+                                                           ARRAY3 const& obstacle,
+                                                           ARRAY2& result,
+                                                           size_t maxIter)
+{
+  ptrdiff_t i, n = N_;
+  Vector& D = work_.D;
+  Vector& Y = work_.Y;
+  if (D.size() != size_t(n + 1))
+    D.set_size(n + 1);
+  if (Y.size() != size_t(n + 1))
+    Y.set_size(n + 1);
+  // the policy with the smaller residual at each node; ties within rounding keep
+  // the current policy, so that the iteration cannot cycle
+  auto updatePolicy = [&]() {
+    bool changed = false;
+    for (ptrdiff_t k = 1; k <= n; k++) {
+      double residual = diag_[k] * result[k] - vals[k];
+      if (k > 1)
+        residual += lower_[k] * result[k - 1];
+      if (k < n)
+        residual += upper_[k] * result[k + 1];
+      double gap = result[k] - obstacle[k] - residual;
+      double eps = 1.0e-12 * std::max(1.0, std::fabs(double(result[k])));
+      if (exercised_[k] ? gap > eps : gap < -eps) {
+        exercised_[k] = !exercised_[k];
+        changed = true;
+      }
+    }
+    return changed;
+  };
+
+  // the initial exercise region, from the starting values
+  exercised_.assign(n + 1, 0);
+  updatePolicy();
+
+  for (size_t iter = 1; iter <= maxIter; ++iter) {
+    // solve with the rows of the exercised nodes replaced by result = obstacle
+    D[n] = exercised_[n] ? 1.0 : diag_[n];
+    Y[n] = exercised_[n] ? double(obstacle[n]) : double(vals[n]);
+    for (i = n - 1; i >= 1; i--) {
+      double up = exercised_[i] ? 0.0 : upper_[i];
+      double lo = exercised_[i + 1] ? 0.0 : lower_[i + 1];
+      double r = up / D[i + 1];
+      D[i] = (exercised_[i] ? 1.0 : diag_[i]) - r * lo;
+      Y[i] = (exercised_[i] ? double(obstacle[i]) : double(vals[i])) - r * Y[i + 1];
+    }
+    result[1] = Y[1] / D[1];
+    for (i = 2; i <= n; i++)
+      result[i] = (Y[i] - (exercised_[i] ? 0.0 : lower_[i]) * result[i - 1]) / D[i];
+
+    if (!updatePolicy())
+      return iter;
+  }
+  ORF_ASSERT(0, "TridiagonalOperator1D: the policy iteration did not converge!");
+  return maxIter;
+}
+
 template<typename ARRAY>
 inline
 double TridiagonalOp1D<ARRAY>::adjustForLowerBoundaryCondition(
@@ -362,9 +1022,10 @@ double TridiagonalOp1D<ARRAY>::adjustForLowerBoundaryCondition(
                                           double upAdjust)
 {
   ORF_ASSERT(diag_.size() >= 4, "TridiagonalOperator1D: grid is too small!");
+  factorized_ = false;
   switch (degree) {
   case 0:
-    return value;       // we set the actual value
+    return lower_[1] * value;   // the edge value is set; its term moves to the right-hand side
   case 1:
     upper_[1] += lower_[1];
     return -lower_[1] * value;
@@ -399,9 +1060,10 @@ double TridiagonalOp1D<ARRAY>::adjustForHigherBoundaryCondition(
                                         double lowAdjust)
 {
   ORF_ASSERT(diag_.size() >= 4, "TridiagonalOperator1D: grid is too small!");
+  factorized_ = false;
   switch (degree) {
   case 0:
-    return value;  // we set the actual value
+    return upper_[N_] * value;  // the edge value is set; its term moves to the right-hand side
   case 1:
     lower_[N_] += upper_[N_];
     return -upper_[N_] * value;
@@ -433,6 +1095,7 @@ TridiagonalOp1D<ARRAY> &
 TridiagonalOp1D<ARRAY>::operator+=(TridiagonalOp1D<ARRAY1> const& rhs)
 {
   ORF_ASSERT(N_ == rhs.N_, "TridiagonalOperator1D: cannot add two operators of different sizes");
+  factorized_ = false;
   for (size_t i = 0; i < lower_.size(); ++i) {
     lower_[i] += rhs.lower_[i];
     diag_[i] += rhs.diag_[i];
@@ -448,6 +1111,7 @@ TridiagonalOp1D<ARRAY> &
 TridiagonalOp1D<ARRAY>::operator-=(TridiagonalOp1D<ARRAY1> const& rhs)
 {
   ORF_ASSERT(N_ == rhs.N_, "Cannot subtract two operators of different sizes");
+  factorized_ = false;
   for (size_t i = 0; i < lower_.size(); ++i) {
     lower_[i] -= rhs.lower_[i];
     diag_[i] -= rhs.diag_[i];
@@ -461,6 +1125,7 @@ inline
 TridiagonalOp1D<ARRAY> &
 TridiagonalOp1D<ARRAY>::operator*=(double rhs)
 {
+  factorized_ = false;
   for (size_t i = 0; i < lower_.size(); ++i) {
     lower_[i] *= rhs;
     diag_[i] *= rhs;
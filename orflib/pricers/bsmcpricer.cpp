@@ -6,6 +6,7 @@
 #include <orflib/pricers/bsmcpricer.hpp>
 #include <orflib/methods/montecarlo/eulerpathgenerator.hpp>
 #include <orflib/methods/montecarlo/brownianbridge.hpp>
+#include <orflib/methods/montecarlo/pcapathgenerator.hpp>
 #include <cmath>
 
 using namespace std;
@@ -39,6 +40,9 @@ spot_(spot), mcparams_(mcparams)
     else if (mcparams.urngType == McParams::UrngType::RANLUX4)
       pathgen_ = SPtrPathGenerator(new EulerPathGenerator<NormalRngRanLux4>(
           timesteps.begin(), timesteps.end(), 1));
+    else if (mcparams.urngType == McParams::UrngType::XOSHIRO256)
+      pathgen_ = SPtrPathGenerator(new EulerPathGenerator<NormalRngXoshiro256>(
+          timesteps.begin(), timesteps.end(), 1));
     else if (mcparams.urngType == McParams::UrngType::SOBOL)
       pathgen_ = SPtrPathGenerator(new EulerPathGenerator<NormalRngSobol>(
           timesteps.begin(), timesteps.end(), 1));
@@ -58,12 +62,37 @@ spot_(spot), mcparams_(mcparams)
     else if (mcparams.urngType == McParams::UrngType::RANLUX4)
       pathgen_ = SPtrPathGenerator(new BrownianBridge<NormalRngRanLux4>(
           timesteps.begin(), timesteps.end(), 1));
+    else if (mcparams.urngType == McParams::UrngType::XOSHIRO256)
+      pathgen_ = SPtrPathGenerator(new BrownianBridge<NormalRngXoshiro256>(
+          timesteps.begin(), timesteps.end(), 1));
     else if (mcparams.urngType == McParams::UrngType::SOBOL)
       pathgen_ = SPtrPathGenerator(new BrownianBridge<NormalRngSobol>(
           timesteps.begin(), timesteps.end(), 1));
     else
       ORF_ASSERT(0, "unknown urng type!");
   }
+  else if (mcparams.pathGenType == McParams::PathGenType::PCA) {
+    if (mcparams.urngType == McParams::UrngType::MINSTDRAND)
+      pathgen_ = SPtrPathGenerator(new PcaPathGenerator<NormalRngMinStdRand>(
+          timesteps.begin(), timesteps.end(), 1, Matrix(), mcparams.pcaRank));
+    else if (mcparams.urngType == McParams::UrngType::MT19937)
+      pathgen_ = SPtrPathGenerator(new PcaPathGenerator<NormalRngMt19937>(
+          timesteps.begin(), timesteps.end(), 1, Matrix(), mcparams.pcaRank));
+    else if (mcparams.urngType == McParams::UrngType::RANLUX3)
+      pathgen_ = SPtrPathGenerator(new PcaPathGenerator<NormalRngRanLux3>(
+          timesteps.begin(), timesteps.end(), 1, Matrix(), mcparams.pcaRank));
+    else if (mcparams.urngType == McParams::UrngType::RANLUX4)
+      pathgen_ = SPtrPathGenerator(new PcaPathGenerator<NormalRngRanLux4>(
+          timesteps.begin(), timesteps.end(), 1, Matrix(), mcparams.pcaRank));
+    else if (mcparams.urngType == McParams::UrngType::XOSHIRO256)
+      pathgen_ = SPtrPathGenerator(new PcaPathGenerator<NormalRngXoshiro256>(
+          timesteps.begin(), timesteps.end(), 1, Matrix(), mcparams.pcaRank));
+    else if (mcparams.urngType == McParams::UrngType::SOBOL)
+      pathgen_ = SPtrPathGenerator(new PcaPathGenerator<NormalRngSobol>(
+          timesteps.begin(), timesteps.end(), 1, Matrix(), mcparams.pcaRank));
+    else
+      ORF_ASSERT(0, "unknown urng type!");
+  }
   else
     ORF_ASSERT(0, "unknown path generator type!");
 
@@ -82,11 +111,19 @@ spot_(spot), mcparams_(mcparams)
     double t2 = fixtimes[i];
     double var = vol_ * vol_ * (t2 - t1);
     stdevs_[i] = sqrt(var);
-    double fwdrate = discyc_->fwdRate(t1, t2);
+    double fwdrate = t2 > t1 ? discyc_->fwdRate(t1, t2) : 0.0;  // a fixing at t = 0 has no drift
     // risk free rate less yield plus convexity adjustment
     drifts_[i] = (fwdrate - divyld_) * (t2 - t1) - 0.5 * var;
     t1 = t2;
   }
+  // let the product know the variances between fixings
+  Matrix variances(fixtimes.size(), 1);
+  for (size_t i = 0; i < fixtimes.size(); ++i)
+    variances(i, 0) = stdevs_[i] * stdevs_[i];
+  prod_->setStepVariances(variances);
+
+  fdrifts_ = arma::conv_to<FVector>::from(drifts_);
+  fstdevs_ = arma::conv_to<FVector>::from(stdevs_);
 
   // Resize the payment amounts
   payamts_.resize(prod->payTimes().size());
@@ -114,4 +151,49 @@ double BsMcPricer::processOnePath(Matrix& pricePath)
   return pv;
 }
 
+
+double BsMcPricer::processOnePathStepwise(Matrix& pricePath)
+{
+  pathgen_->beginPath(pricePath);
+  prod_->beginPath();
+  // generate, convert and evaluate one fixing at a time, until the product is decided
+  double spot = spot_;
+  for (size_t i = 0; i < pricePath.n_rows; ++i) {
+    pathgen_->nextStep(i, pricePath);
+    double normaldeviate = pricePath(i, 0);
+    pricePath(i, 0) = spot * exp(drifts_[i] + stdevs_[i] * normaldeviate);
+    spot = pricePath(i, 0);
+    if (prod_->evalFixing(i, pricePath))
+      break;
+  }
+  payamts_ = prod_->payAmounts();
+
+  double pv = 0.0;
+  for (size_t i = 0; i < payamts_.size(); ++i)
+    pv += discfactors_[i] * payamts_[i];
+
+  return pv;
+}
+
+
+double BsMcPricer::processOnePath(FMatrix& pricePath)
+{
+  pathgen_->next(pricePath);
+  // convert the normal deviates to a price path in-place, in single precision
+  float spot = static_cast<float>(spot_);
+  for (size_t i = 0; i < pricePath.n_rows; ++i) {
+    float normaldeviate = pricePath(i, 0);
+    pricePath(i, 0) = spot * exp(fdrifts_[i] + fstdevs_[i] * normaldeviate);
+    spot = pricePath(i, 0);
+  }
+  prod_->eval(pricePath);
+  payamts_ = prod_->payAmounts();
+
+  double pv = 0.0;
+  for (size_t i = 0; i < payamts_.size(); ++i)
+    pv += discfactors_[i] * payamts_[i];
+
+  return pv;
+}
+
 END_NAMESPACE(orf)
@@ -36,11 +36,27 @@ public:
 
 protected:
 
+  /** Runs the simulation with single precision paths */
+  template<typename ITER>
+  void simulateSingle(StatisticsCalculator<ITER>& statsCalc, unsigned long npaths);
+
   /** Creates and processes one price path.
       It returns the PV of the product
       */
   double processOnePath(Matrix& pricePath);
 
+  /** Creates and processes one single precision price path.
+      The path is generated and converted to prices in float,
+      while the PV is accumulated in double.
+  */
+  double processOnePath(FMatrix& pricePath);
+
+  /** Creates and processes one price path time step by time step,
+      stopping as soon as the product is decided.
+      It returns the PV of the product
+  */
+  double processOnePathStepwise(Matrix& pricePath);
+
 private:
   SPtrProduct prod_;      // pointer to the product
   SPtrYieldCurve discyc_; // pointer to the discount curve
@@ -53,6 +69,8 @@ private:
   Vector discfactors_;         // caches the pre-computed discount factors
   Vector drifts_;              // caches the pre-computed asset drifts
   Vector stdevs_;              // caches the pre-computed standard deviations 
+  FVector fdrifts_;            // the drifts in single precision
+  FVector fstdevs_;            // the standard deviations in single precision
 
   Vector payamts_;             // scratch array for writing the payments after each simulation
 };
@@ -69,11 +87,36 @@ size_t BsMcPricer::nVariables()
 template<typename ITER>
 void BsMcPricer::simulate(StatisticsCalculator<ITER>& statsCalc, unsigned long npaths)
 {
+  if (mcparams_.pathPrecision == McParams::PathPrecision::SINGLE) {
+    simulateSingle(statsCalc, npaths);
+    return;
+  }
   // create the price path matrix
   Matrix pricePath(pathgen_->nTimeSteps(), pathgen_->nFactors());
   // check the size of the statistics calcuilator
   ORF_ASSERT(statsCalc.nVariables() == nVariables(), "the statistics calculator must track only one variable!");
 
+  // This is the HOT loop
+  if (prod_->decidesEarly()) {
+    for (unsigned long i = 0; i < npaths; ++i) {
+      double pv = processOnePathStepwise(pricePath);
+      statsCalc.addSample(&pv, &pv + 1);
+    }
+    return;
+  }
+  for (unsigned long i = 0; i < npaths; ++i) {
+    double pv = processOnePath(pricePath);
+    statsCalc.addSample(&pv, &pv + 1);
+  }
+}
+
+template<typename ITER>
+void BsMcPricer::simulateSingle(StatisticsCalculator<ITER>& statsCalc, unsigned long npaths)
+{
+  // the path is float, the PV and the statistics stay in double
+  FMatrix pricePath(pathgen_->nTimeSteps(), pathgen_->nFactors());
+  ORF_ASSERT(statsCalc.nVariables() == nVariables(), "the statistics calculator must track only one variable!");
+
   // This is the HOT loop
   for (unsigned long i = 0; i < npaths; ++i) {
     double pv = processOnePath(pricePath);
@@ -6,6 +6,7 @@
 #include <orflib/pricers/multiassetbsmcpricer.hpp>
 #include <orflib/methods/montecarlo/eulerpathgenerator.hpp>
 #include <orflib/methods/montecarlo/brownianbridge.hpp>
+#include <orflib/methods/montecarlo/pcapathgenerator.hpp>
 
 #include <cmath>
 
@@ -51,6 +52,9 @@ spots_(spots), mcparams_(mcparams)
     else if (mcparams.urngType == McParams::UrngType::RANLUX4)
       pathgen_ = SPtrPathGenerator(new EulerPathGenerator<NormalRngRanLux4>(
         timesteps.begin(), timesteps.end(), nassets, correlMatrix));
+    else if (mcparams.urngType == McParams::UrngType::XOSHIRO256)
+      pathgen_ = SPtrPathGenerator(new EulerPathGenerator<NormalRngXoshiro256>(
+        timesteps.begin(), timesteps.end(), nassets, correlMatrix));
     else if (mcparams.urngType == McParams::UrngType::SOBOL)
       pathgen_ = SPtrPathGenerator(new EulerPathGenerator<NormalRngSobol>(
         timesteps.begin(), timesteps.end(), nassets, correlMatrix));
@@ -70,12 +74,37 @@ spots_(spots), mcparams_(mcparams)
     else if (mcparams.urngType == McParams::UrngType::RANLUX4)
       pathgen_ = SPtrPathGenerator(new BrownianBridge<NormalRngRanLux4>(
         timesteps.begin(), timesteps.end(), nassets, correlMatrix));
+    else if (mcparams.urngType == McParams::UrngType::XOSHIRO256)
+      pathgen_ = SPtrPathGenerator(new BrownianBridge<NormalRngXoshiro256>(
+        timesteps.begin(), timesteps.end(), nassets, correlMatrix));
     else if (mcparams.urngType == McParams::UrngType::SOBOL)
       pathgen_ = SPtrPathGenerator(new BrownianBridge<NormalRngSobol>(
         timesteps.begin(), timesteps.end(), nassets, correlMatrix));
     else
       ORF_ASSERT(0, "unknown urng type!");
   }
+  else if (mcparams.pathGenType == McParams::PathGenType::PCA) {
+    if (mcparams.urngType == McParams::UrngType::MINSTDRAND)
+      pathgen_ = SPtrPathGenerator(new PcaPathGenerator<NormalRngMinStdRand>(
+        timesteps.begin(), timesteps.end(), nassets, correlMatrix, mcparams.pcaRank));
+    else if (mcparams.urngType == McParams::UrngType::MT19937)
+      pathgen_ = SPtrPathGenerator(new PcaPathGenerator<NormalRngMt19937>(
+        timesteps.begin(), timesteps.end(), nassets, correlMatrix, mcparams.pcaRank));
+    else if (mcparams.urngType == McParams::UrngType::RANLUX3)
+      pathgen_ = SPtrPathGenerator(new PcaPathGenerator<NormalRngRanLux3>(
+        timesteps.begin(), timesteps.end(), nassets, correlMatrix, mcparams.pcaRank));
+    else if (mcparams.urngType == McParams::UrngType::RANLUX4)
+      pathgen_ = SPtrPathGenerator(new PcaPathGenerator<NormalRngRanLux4>(
+        timesteps.begin(), timesteps.end(), nassets, correlMatrix, mcparams.pcaRank));
+    else if (mcparams.urngType == McParams::UrngType::XOSHIRO256)
+      pathgen_ = SPtrPathGenerator(new PcaPathGenerator<NormalRngXoshiro256>(
+        timesteps.begin(), timesteps.end(), nassets, correlMatrix, mcparams.pcaRank));
+    else if (mcparams.urngType == McParams::UrngType::SOBOL)
+      pathgen_ = SPtrPathGenerator(new PcaPathGenerator<NormalRngSobol>(
+        timesteps.begin(), timesteps.end(), nassets, correlMatrix, mcparams.pcaRank));
+    else
+      ORF_ASSERT(0, "unknown urng type!");
+  }
   else
     ORF_ASSERT(0, "unknown path generator type!");
 
@@ -97,13 +126,24 @@ spots_(spots), mcparams_(mcparams)
     for (size_t i = 0; i < fixtimes.size(); ++i) {
       double t2 = fixtimes[i];
       double var = vols_[j] * vols_[j] * (t2 - t1);
-      stdevs_(i, j) = vols_[j];
-      double fwdrate = discyc_->fwdRate(t1, t2);
+      stdevs_(i, j) = sqrt(var);
+      double fwdrate = t2 > t1 ? discyc_->fwdRate(t1, t2) : 0.0;  // a fixing at t = 0 has no drift
       // risk free rate less yield plus convexity adjustment
       drifts_(i, j) = (fwdrate - divylds_[j]) * (t2 - t1) - 0.5 * var;
       t1 = t2;
     }
   }
+  // let the product know the variances between fixings
+  Matrix variances(fixtimes.size(), nassets);
+  for (size_t j = 0; j < nassets; ++j)
+    for (size_t i = 0; i < fixtimes.size(); ++i)
+      variances(i, j) = stdevs_(i, j) * stdevs_(i, j);
+  prod_->setStepVariances(variances);
+
+  fdrifts_ = arma::conv_to<FMatrix>::from(drifts_);
+  fstdevs_ = arma::conv_to<FMatrix>::from(stdevs_);
+  fspots_ = arma::conv_to<FVector>::from(spots_);
+  fcurrspots_.set_size(fspots_.size());
 
   // Resize the payment amounts
   payamts_.resize(prod->payTimes().size());
@@ -133,4 +173,54 @@ double MultiAssetBsMcPricer::processOnePath(Matrix& pricePath)
   return pv;
 }
 
+double MultiAssetBsMcPricer::processOnePathStepwise(Matrix& pricePath)
+{
+  pathgen_->beginPath(pricePath);
+  prod_->beginPath();
+  size_t nassets = prod_->nAssets();
+  currspots_ = spots_;               // initialize the current spots array
+  // generate, convert and evaluate one fixing at a time, until the product is decided
+  for (size_t i = 0; i < pricePath.n_rows; ++i) {
+    pathgen_->nextStep(i, pricePath);
+    for (size_t j = 0; j < nassets; ++j) {
+      double normaldeviate = pricePath(i, j);
+      pricePath(i, j) = currspots_[j] * exp(drifts_(i, j) + stdevs_(i, j) * normaldeviate);
+      currspots_[j] = pricePath(i, j);
+    }
+    if (prod_->evalFixing(i, pricePath))
+      break;
+  }
+  payamts_ = prod_->payAmounts();
+
+  double pv = 0.0;
+  for (size_t i = 0; i < payamts_.size(); ++i)
+    pv += discfactors_[i] * payamts_[i];
+
+  return pv;
+}
+
+double MultiAssetBsMcPricer::processOnePath(FMatrix& pricePath)
+{
+  pathgen_->next(pricePath);
+  size_t nassets = prod_->nAssets();
+  for (size_t j = 0; j < nassets; ++j)
+    fcurrspots_[j] = fspots_[j];    // initialize the current spots array
+  // convert the normal deviates to a price path in-place, in single precision
+  for (size_t i = 0; i < pricePath.n_rows; ++i) {
+    for (size_t j = 0; j < nassets; ++j) {
+      float normaldeviate = pricePath(i, j);
+      pricePath(i, j) = fcurrspots_[j] * exp(fdrifts_(i, j) + fstdevs_(i, j) * normaldeviate);
+      fcurrspots_[j] = pricePath(i, j);
+    }
+  }
+  prod_->eval(pricePath);
+  payamts_ = prod_->payAmounts();
+
+  double pv = 0.0;
+  for (size_t i = 0; i < payamts_.size(); ++i)
+    pv += discfactors_[i] * payamts_[i];
+
+  return pv;
+}
+
 END_NAMESPACE(orf)
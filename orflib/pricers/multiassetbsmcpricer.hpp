@@ -40,11 +40,27 @@ public:
 
 protected:
 
+  /** Runs the simulation with single precision paths */
+  template<typename ITER>
+  void simulateSingle(StatisticsCalculator<ITER>& statsCalc, unsigned long npaths);
+
   /** Creates and processes one price path.
       It returns the PV of the product
   */
   double processOnePath(Matrix& pricePath);
 
+  /** Creates and processes one single precision price path.
+      The path is generated and converted to prices in float,
+      while the PV is accumulated in double.
+  */
+  double processOnePath(FMatrix& pricePath);
+
+  /** Creates and processes one price path time step by time step,
+      stopping as soon as the product is decided.
+      It returns the PV of the product
+  */
+  double processOnePathStepwise(Matrix& pricePath);
+
 private:
   SPtrProduct prod_;               // pointer to the product
   SPtrYieldCurve discyc_;          // pointer to the discount curve
@@ -57,8 +73,12 @@ private:
   Vector discfactors_;         // caches the pre-computed discount factors
   Matrix drifts_;              // caches the pre-computed asset drifts, one column per asset
   Matrix stdevs_;              // caches the pre-computed standard deviations, one column per asset 
+  FMatrix fdrifts_;            // the drifts in single precision
+  FMatrix fstdevs_;            // the standard deviations in single precision
+  FVector fspots_;             // the initial spots in single precision
 
   Vector currspots_;           // scratch array with the current spots, one per asset
+  FVector fcurrspots_;         // scratch array with the current spots in single precision
   Vector payamts_;             // scratch array for writting the payments after each simulation
 };
 
@@ -74,11 +94,36 @@ size_t MultiAssetBsMcPricer::nVariables()
 template<typename ITER>
 void MultiAssetBsMcPricer::simulate(StatisticsCalculator<ITER>& statsCalc, unsigned long npaths)
 {
+  if (mcparams_.pathPrecision == McParams::PathPrecision::SINGLE) {
+    simulateSingle(statsCalc, npaths);
+    return;
+  }
   // create the price path matrix
   Matrix pricePath(pathgen_->nTimeSteps(), pathgen_->nFactors());
   // check the size of the statistics calculator
   ORF_ASSERT(statsCalc.nVariables() == nVariables(), "the statistics calculator must track as many variables as the pricer captures!");
 
+  // This is the HOT loop
+  if (prod_->decidesEarly()) {
+    for (unsigned long i = 0; i < npaths; ++i) {
+      double pv = processOnePathStepwise(pricePath);
+      statsCalc.addSample(&pv, &pv + 1);
+    }
+    return;
+  }
+  for (unsigned long i = 0; i < npaths; ++i) {
+    double pv = processOnePath(pricePath);
+    statsCalc.addSample(&pv, &pv + 1);
+  }
+}
+
+template<typename ITER>
+void MultiAssetBsMcPricer::simulateSingle(StatisticsCalculator<ITER>& statsCalc, unsigned long npaths)
+{
+  // the path is float, the PV and the statistics stay in double
+  FMatrix pricePath(pathgen_->nTimeSteps(), pathgen_->nFactors());
+  ORF_ASSERT(statsCalc.nVariables() == nVariables(), "the statistics calculator must track only one variable!");
+
   // This is the HOT loop
   for (unsigned long i = 0; i < npaths; ++i) {
     double pv = processOnePath(pricePath);
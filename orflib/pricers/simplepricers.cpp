@@ -7,6 +7,7 @@
 #include <orflib/math/stats/normaldistribution.hpp>
 
 #include <cmath>
+#include <cstring>
 
 BEGIN_NAMESPACE(orf)
 
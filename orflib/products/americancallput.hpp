@@ -18,9 +18,32 @@ public:
   /** Initializing ctor */
   AmericanCallPut(int payoffType, double strike, double timeToExp);
 
+  /** Returns a copy of this product */
+  virtual std::shared_ptr<Product> clone() const override
+  {
+    return std::shared_ptr<Product>(new AmericanCallPut(*this));
+  }
+
   /** Evaluates the product at fixing time index idx
   */
   virtual void eval(size_t idx, Vector const& pricePath, double contValue);
+
+  /** Evaluates the product at fixing time index idx at each node of a PDE grid slice */
+  virtual void evalSlice(size_t idx, Matrix const& spots, double* values) const override;
+
+  /** The option can be exercised at any time up to expiration */
+  virtual bool hasEarlyExercise() const override { return true; }
+
+  /** Returns the intrinsic value */
+  virtual double exerciseValue(Vector const& spots) const override;
+
+  /** A call is exercised above the critical spot, a put below */
+  virtual int exerciseSide() const override { return payoffType_; }
+
+  /** With the early exercise enforced at every time step, only the expiration is an event */
+  virtual void timeStepsWithoutExercise(size_t nsteps,
+                                        std::vector<double>& timesteps,
+                                        std::vector<ptrdiff_t>& stepindex) const override;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -63,6 +86,40 @@ inline void AmericanCallPut::eval(size_t idx, Vector const& spots, double contVa
   }
 }
 
+inline void AmericanCallPut::evalSlice(size_t idx, Matrix const& spots, double* values) const
+{
+  double const* S = spots.colptr(0);
+  double K = strike_, w = payoffType_;
+  if (idx == payAmounts_.size() - 1) { // this is the last index
+    for (size_t i = 0; i < spots.n_rows; ++i) {
+      double payoff = (S[i] - K) * w;
+      values[i] = payoff > 0.0 ? payoff : 0.0;
+    }
+  }
+  else {  // this is not the last index, check the exercise condition
+    for (size_t i = 0; i < spots.n_rows; ++i) {
+      double intrinsicValue = (S[i] - K) * w;
+      intrinsicValue = intrinsicValue >= 0.0 ? intrinsicValue : 0.0;
+      values[i] = values[i] >= intrinsicValue ? values[i] : intrinsicValue;
+    }
+  }
+}
+
+inline double AmericanCallPut::exerciseValue(Vector const& spots) const
+{
+  double intrinsicValue = (spots[0] - strike_) * payoffType_;
+  return intrinsicValue > 0.0 ? intrinsicValue : 0.0;
+}
+
+inline void AmericanCallPut::timeStepsWithoutExercise(size_t nsteps,
+                                                      std::vector<double>& timesteps,
+                                                      std::vector<ptrdiff_t>& stepindex) const
+{
+  std::vector<double> eventtimes = { 0.0, timeToExp_ };
+  std::vector<ptrdiff_t> eventindex = { -1, ptrdiff_t(fixTimes_.size() - 1) };
+  fillTimeSteps(eventtimes, eventindex, nsteps, timesteps, stepindex);
+}
+
 END_NAMESPACE(orf)
 
 #endif // ORF_AMERICANCALLPUT_HPP
@@ -23,6 +23,12 @@ public:
                      Vector const& fixingTimes,
                      Vector const& assetQuantities);
 
+  /** Returns a copy of this product */
+  virtual std::shared_ptr<Product> clone() const override
+  {
+    return std::shared_ptr<Product>(new AsianBasketCallPut(*this));
+  }
+
   /** The number of assets this product depends on */
   virtual size_t nAssets() const override;
 
@@ -32,11 +38,22 @@ public:
       */
   virtual void eval(Matrix const& pricePath) override;
 
-  /** Evaluates the product at fixing time index idx
+  /** Evaluates the product given the passed-in single precision path */
+  virtual void eval(FMatrix const& pricePath) override;
+
+  /** Evaluates the product at fixing time index idx, given the spots of all assets.
+      Only for a single fixing, where the average is the basket value at expiration.
   */
   virtual void eval(size_t idx, Vector const& spots, double contValue) override;
 
+  /** Evaluates the payoff at each node of a PDE grid slice, for a single fixing */
+  virtual void evalSlice(size_t idx, Matrix const& spots, double* values) const override;
+
 private:
+  // evaluates the payoff on a path of either precision; the average is taken in double
+  template <typename MAT>
+  void evalPath(MAT const& pricePath);
+
   int payoffType_;          // 1: call; -1 put
   double strike_;
   Vector assetQuantities_;  // number of units of each asset in the basket
@@ -79,6 +96,17 @@ size_t AsianBasketCallPut::nAssets() const
 }
 
 inline void AsianBasketCallPut::eval(Matrix const& pricePath)
+{
+  evalPath(pricePath);
+}
+
+inline void AsianBasketCallPut::eval(FMatrix const& pricePath)
+{
+  evalPath(pricePath);
+}
+
+template <typename MAT>
+inline void AsianBasketCallPut::evalPath(MAT const& pricePath)
 {
   double bsktAvg = 0;
   size_t nfixings = pricePath.n_rows;
@@ -103,10 +131,50 @@ inline void AsianBasketCallPut::eval(Matrix const& pricePath)
     payAmounts_[0] = bsktAvg >= strike_ ? 0.0 : strike_ - bsktAvg;
 }
 
-// Not implemented
+// With more fixings the payoff depends on the running average, which is not a spot
 inline void AsianBasketCallPut::eval(size_t idx, Vector const& spots, double contValue)
 {
-  ORF_ASSERT(0, "not implemented!");
+  // the continuation value is not used
+  ORF_ASSERT(fixTimes_.size() == 1,
+    "AsianBasketCallPut: the evaluation at a fixing needs a single fixing!");
+  ORF_ASSERT(idx == 0, "AsianBasketCallPut: wrong fixing time index!");
+  ORF_ASSERT(spots.size() == assetQuantities_.size(),
+    "AsianBasketCallPut: number of assets mismatch in the spots!");
+  double bsktval = 0.0;
+  for (size_t j = 0; j < spots.size(); ++j)
+    bsktval += assetQuantities_[j] * spots[j];
+
+  if (payoffType_ == 1)
+    payAmounts_[0] = bsktval >= strike_ ? bsktval - strike_ : 0.0;
+  else
+    payAmounts_[0] = bsktval >= strike_ ? 0.0 : strike_ - bsktval;
+}
+
+inline void AsianBasketCallPut::evalSlice(size_t idx, Matrix const& spots, double* values) const
+{
+  // the continuation values are not used
+  ORF_ASSERT(fixTimes_.size() == 1,
+    "AsianBasketCallPut: the evaluation at a fixing needs a single fixing!");
+  ORF_ASSERT(idx == 0, "AsianBasketCallPut: wrong fixing time index!");
+  ORF_ASSERT(spots.n_cols == assetQuantities_.size(),
+    "AsianBasketCallPut: number of assets mismatch in the spots!");
+  size_t n = spots.n_rows;
+  for (size_t i = 0; i < n; ++i)
+    values[i] = 0.0;
+  // accumulate the basket values asset by asset, down the contiguous columns
+  for (size_t j = 0; j < spots.n_cols; ++j) {
+    double const* S = spots.colptr(j);
+    double q = assetQuantities_[j];
+    for (size_t i = 0; i < n; ++i)
+      values[i] += q * S[i];
+  }
+  double K = strike_;
+  if (payoffType_ == 1)
+    for (size_t i = 0; i < n; ++i)
+      values[i] = values[i] >= K ? values[i] - K : 0.0;
+  else
+    for (size_t i = 0; i < n; ++i)
+      values[i] = values[i] >= K ? 0.0 : K - values[i];
 }
 
 END_NAMESPACE(orf)
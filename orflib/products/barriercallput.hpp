@@ -7,10 +7,19 @@
 #define ORF_BARRIERCALLPUT_HPP
 
 #include <orflib/products/product.hpp>
+#include <cmath>
 
 BEGIN_NAMESPACE(orf)
 
-/** The Barrier call/put class
+/** The Barrier call/put class.
+    The barrier is monitored monthly, weekly, daily or continuously.
+    By default the fixing times are the monitoring dates (daily ones for continuous monitoring).
+    Alternatively the product can be simulated on nSimDates equally spaced dates; then eval(Matrix)
+    multiplies the payoff by the Brownian bridge probability of not crossing the barrier
+    between consecutive dates. For discrete monitoring the barrier is first shifted away from the spot
+    by the Broadie-Glasserman-Kou correction exp(0.5826 sigma sqrt(dt)).
+    The correction needs the variances passed in by the pricer via setStepVariances().
+    The simulation dates are for the Monte Carlo pricers only; the PDE solvers need the monitoring dates.
 */
 class BarrierCallPut : public Product
 {
@@ -20,11 +29,22 @@ public:
   {
     MONTHLY,      // 12/year
     WEEKLY,       // 52/year
-    DAILY         // 365/year
+    DAILY,        // 365/year
+    CONTINUOUS
   };
 
-  /** Initializing ctor */
-  BarrierCallPut(int payoffType, double strike, double barrier, std::string barrierType, Freq frequency, double timeToExp);
+  /** Initializing ctor.
+      If nSimDates is zero, the fixing times are the monitoring dates, otherwise they are
+      nSimDates equally spaced dates, plus the t = 0 fixing, for Monte Carlo pricing only.
+  */
+  BarrierCallPut(int payoffType, double strike, double barrier, std::string barrierType, Freq frequency, double timeToExp,
+                 size_t nSimDates = 0);
+
+  /** Returns a copy of this product */
+  virtual std::shared_ptr<Product> clone() const override
+  {
+    return std::shared_ptr<Product>(new BarrierCallPut(*this));
+  }
 
   /** The number of assets this product depends on */
   virtual size_t nAssets() const override { return 1; }
@@ -39,12 +59,33 @@ public:
   */
   virtual void eval(size_t idx, Vector const& spots, double contValue) override;
 
+  /** Evaluates the product at fixing time index idx at each node of a PDE grid slice */
+  virtual void evalSlice(size_t idx, Matrix const& spots, double* values) const override;
+
+  /** A knock-out is decided as soon as the barrier is breached */
+  virtual bool decidesEarly() const override { return true; }
+
+  /** Starts the fixing by fixing evaluation of a new path */
+  virtual void beginPath() override;
+
+  /** Checks the barrier at fixing idx; returns true once knocked out or at the last fixing */
+  virtual bool evalFixing(size_t idx, Matrix const& pricePath) override;
+
+  /** Stores the log-spot variances between fixings, used by the barrier crossing correction */
+  virtual void setStepVariances(Matrix const& variances) override;
+
   /** Returns whether the grid needs to be aligned for PDE solving */
   bool needsAlignment() override;
 
   /** Returns the alignment vector */
   std::vector<double> getAlignmentVector() override;
 
+  /** The strike and the barrier are the critical points */
+  virtual std::vector<double> getCriticalPoints() const override { return { strike_, barrier_ }; }
+
+  /** A continuously monitored barrier is a knock-out level */
+  virtual void getKnockOutLevels(double& lower, double& upper) const override;
+
 private:
   int payoffType_;          // 1: call; -1 put
   double strike_;
@@ -52,13 +93,21 @@ private:
   std::string barrier_type_;
   Freq frequency_;
   double timeToExp_;
+  double monitoringDt_;      // time between monitoring dates, zero if continuous
+  size_t nSimDates_;         // number of coarse simulation dates, zero if the fixings are the monitoring dates
+  bool bridgeCorrection_;    // true if the crossing probability between fixings is accounted for
+  Vector stepVariances_;     // log-spot variances between fixings
+  Vector effBarriers_;       // barrier levels used between fixings, after the discrete monitoring shift
+  double survival_;          // probability of not having crossed the barrier so far on this path
+  double prevSpot_;          // the spot at the previous fixing on this path
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 // Inline definitions
 
 inline
-BarrierCallPut::BarrierCallPut(int payoffType, double strike, double barrier, std::string barrierType, Freq frequency, double timeToExp)
+BarrierCallPut::BarrierCallPut(int payoffType, double strike, double barrier, std::string barrierType, Freq frequency, double timeToExp,
+                               size_t nSimDates)
   : payoffType_(payoffType), strike_(strike), barrier_(barrier), frequency_(frequency), barrier_type_(barrierType), timeToExp_(timeToExp)
 {
   ORF_ASSERT(payoffType == 1 || payoffType == -1, "BarrierCallPut: the payoff type must be 1 (call) or -1 (put)!");
@@ -82,6 +131,7 @@ BarrierCallPut::BarrierCallPut(int payoffType, double strike, double barrier, st
     time_factor = 7.0;
     break;
   case BarrierCallPut::Freq::DAILY:
+  case BarrierCallPut::Freq::CONTINUOUS:   // daily fixings, unless simulation dates are given
     monitoring_freq = 365.0;
     time_factor = 1.0;
     break;
@@ -108,6 +158,17 @@ BarrierCallPut::BarrierCallPut(int payoffType, double strike, double barrier, st
     fixTimes_[i + offset] = i * (time_factor/365.0) + stub_time/365.0;
   fixTimes_[rounded_up_nfixings - 1] = timeToExp_;
 
+  monitoringDt_ = frequency == Freq::CONTINUOUS ? 0.0 : time_factor / 365.0;
+  nSimDates_ = nSimDates;
+  bridgeCorrection_ = frequency == Freq::CONTINUOUS || nSimDates > 0;
+  if (nSimDates > 0) {
+    // coarse simulation dates, the monitoring in between is handled by the bridge correction
+    fixTimes_.resize(nSimDates + 1);
+    fixTimes_[0] = 0.0;
+    for (size_t i = 1; i <= nSimDates; ++i)
+      fixTimes_[i] = timeToExp_ * i / nSimDates;
+  }
+
   payTimes_ = fixTimes_;
 
   // this product takes either its continuation value or zero at the fixing times
@@ -116,13 +177,49 @@ BarrierCallPut::BarrierCallPut(int payoffType, double strike, double barrier, st
 
 inline void BarrierCallPut::eval(Matrix const& pricePath)
 {
-  ORF_ASSERT(0, "Not implemented yet!");
+  size_t nfixings = pricePath.n_rows;
+  ORF_ASSERT(nfixings == fixTimes_.size(), "BarrierCallPut: number of fixings mismatch in price path!");
+  beginPath();
+  for (size_t i = 0; i < nfixings; ++i) {
+    if (evalFixing(i, pricePath))
+      break;
+  }
+}
+
+inline void BarrierCallPut::beginPath()
+{
+  ORF_ASSERT(!bridgeCorrection_ || stepVariances_.size() == fixTimes_.size(),
+    "BarrierCallPut: the step variances must be set for the barrier crossing correction!");
+  survival_ = 1.0;
+  prevSpot_ = 0.0;
+  payAmounts_.zeros();
+}
 
-  // This implementation not neccessary
+inline bool BarrierCallPut::evalFixing(size_t idx, Matrix const& pricePath)
+{
+  double spot = pricePath(idx, 0);
+  double barrier = bridgeCorrection_ ? effBarriers_[idx] : barrier_;
+  bool up = barrier_type_[0] == 'u';
+  if (up ? spot >= barrier - 0.00001 : spot <= barrier + 0.00001)
+    return true;                         // knocked out, all payments are zero
+  // probability of not crossing the barrier since the previous fixing
+  if (bridgeCorrection_ && idx > 0 && stepVariances_[idx] > 0.0) {
+    double x1 = std::log(barrier / prevSpot_);
+    double x2 = std::log(barrier / spot);
+    survival_ *= 1.0 - std::exp(-2.0 * x1 * x2 / stepVariances_[idx]);
+  }
+  prevSpot_ = spot;
+
+  if (idx + 1 < fixTimes_.size())
+    return false;
+  double payoff = (spot - strike_) * payoffType_;
+  payAmounts_[idx] = payoff > 0.0 ? payoff * survival_ : 0.0;
+  return true;
 }
 
 inline void BarrierCallPut::eval(size_t idx, Vector const& spots, double contValue)
 {
+  ORF_ASSERT(nSimDates_ == 0, "BarrierCallPut: the simulation dates would skip the monitoring dates!");
 	double spot = spots[0];
 
 	if (idx == payAmounts_.size() - 1) { // this is the last index
@@ -144,6 +241,56 @@ inline void BarrierCallPut::eval(size_t idx, Vector const& spots, double contVal
 	}
 }
 
+inline void BarrierCallPut::evalSlice(size_t idx, Matrix const& spots, double* values) const
+{
+  // the PDE solvers check the barrier at the fixings only, so they must be the monitoring dates
+  ORF_ASSERT(nSimDates_ == 0, "BarrierCallPut: the simulation dates would skip the monitoring dates!");
+  double const* S = spots.colptr(0);
+  size_t n = spots.n_rows;
+  double K = strike_, w = payoffType_;
+  // the alive region is below an up barrier, above a down barrier
+  bool up = barrier_type_[0] == 'u';
+  double lo = up ? -HUGE_VAL : barrier_ + 0.00001;
+  double hi = up ? barrier_ - 0.00001 : HUGE_VAL;
+  if (idx == payAmounts_.size() - 1) { // this is the last index
+    for (size_t i = 0; i < n; ++i) {
+      double payoff = (S[i] - K) * w;
+      values[i] = payoff > 0.0 && S[i] > lo && S[i] < hi ? payoff : 0.0;
+    }
+  }
+  else {  // this is not the last index, knock out the nodes beyond the barrier
+    for (size_t i = 0; i < n; ++i)
+      values[i] = S[i] > lo && S[i] < hi ? values[i] : 0.0;
+  }
+}
+
+inline void BarrierCallPut::setStepVariances(Matrix const& variances)
+{
+  ORF_ASSERT(variances.n_rows == fixTimes_.size(), "BarrierCallPut: need one variance per fixing time!");
+  stepVariances_.resize(variances.n_rows);
+  effBarriers_.resize(variances.n_rows);
+  double sign = barrier_type_[0] == 'u' ? 1.0 : -1.0;
+  for (size_t i = 0; i < variances.n_rows; ++i) {
+    stepVariances_[i] = variances(i, 0);
+    // Broadie-Glasserman-Kou shift for discrete monitoring, beta = -zeta(1/2)/sqrt(2*pi)
+    double dt = i > 0 ? fixTimes_[i] - fixTimes_[i - 1] : 0.0;
+    double shift = 0.0;
+    if (monitoringDt_ > 0.0 && dt > 0.0)
+      shift = 0.5826 * std::sqrt(stepVariances_[i] / dt * monitoringDt_);
+    effBarriers_[i] = barrier_ * std::exp(sign * shift);
+  }
+}
+
+inline void BarrierCallPut::getKnockOutLevels(double& lower, double& upper) const
+{
+  lower = 0.0;
+  upper = HUGE_VAL;
+  // the discrete monitoring only knocks out at the fixings
+  if (frequency_ != Freq::CONTINUOUS)
+    return;
+  (barrier_type_[0] == 'u' ? upper : lower) = barrier_;
+}
+
 inline bool BarrierCallPut::needsAlignment()
 {
   return true;
@@ -18,6 +18,12 @@ public:
   /** Initializing ctor */
   EuropeanCallPut(int payoffType, double strike, double timeToExp);
 
+  /** Returns a copy of this product */
+  virtual std::shared_ptr<Product> clone() const override
+  {
+    return std::shared_ptr<Product>(new EuropeanCallPut(*this));
+  }
+
   /** The number of assets this product depends on */
   virtual size_t nAssets() const override { return 1; }
 
@@ -27,11 +33,24 @@ public:
   */
   virtual void eval(Matrix const& pricePath) override;
 
+  /** Evaluates the product given the passed-in single precision path */
+  virtual void eval(FMatrix const& pricePath) override;
+
   /** Evaluates the product at fixing time index idx
   */
   virtual void eval(size_t idx, Vector const& spots, double contValue) override;
 
+  /** Evaluates the payoff at each node of a PDE grid slice */
+  virtual void evalSlice(size_t idx, Matrix const& spots, double* values) const override;
+
+  /** The strike is the critical point */
+  virtual std::vector<double> getCriticalPoints() const override { return { strike_ }; }
+
 protected:
+  // evaluates the payoff on a path of either precision
+  template <typename MAT>
+  void evalPath(MAT const& pricePath);
+
   int payoffType_;     // 1: call; -1 put
   double strike_;
   double timeToExp_;
@@ -62,6 +81,17 @@ EuropeanCallPut::EuropeanCallPut(int payoffType, double strike, double timeToExp
 }
 
 inline void EuropeanCallPut::eval(Matrix const& pricePath)
+{
+  evalPath(pricePath);
+}
+
+inline void EuropeanCallPut::eval(FMatrix const& pricePath)
+{
+  evalPath(pricePath);
+}
+
+template <typename MAT>
+inline void EuropeanCallPut::evalPath(MAT const& pricePath)
 {
   double S_T = pricePath(0, 0);
   if (payoffType_ == 1)
@@ -82,6 +112,18 @@ inline void EuropeanCallPut::eval(size_t idx, Vector const& spots, double contVa
     payAmounts_[idx] = S_T >= strike_ ? 0.0 : strike_ - S_T;
 }
 
+inline void EuropeanCallPut::evalSlice(size_t idx, Matrix const& spots, double* values) const
+{
+  // the continuation values are not used
+  ORF_ASSERT(idx == 0, "EuropeanCallPut: wrong fixing time index!");
+  double const* S = spots.colptr(0);
+  double K = strike_, w = payoffType_;
+  for (size_t i = 0; i < spots.n_rows; ++i) {
+    double payoff = (S[i] - K) * w;
+    values[i] = payoff > 0.0 ? payoff : 0.0;
+  }
+}
+
 END_NAMESPACE(orf)
 
 #endif // ORF_EUROPEANCALLPUT_HPP
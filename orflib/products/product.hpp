@@ -10,6 +10,7 @@
 #include <orflib/exception.hpp>
 #include <orflib/sptr.hpp>
 #include <orflib/math/matrix.hpp>
+#include <cmath>
 
 BEGIN_NAMESPACE(orf)
 
@@ -25,6 +26,11 @@ public:
   /** Dtor */
   virtual ~Product() {}
 
+  /** Returns a copy of this product. Products keep the payment amounts of the last
+      evaluation, so concurrent pricings must each use their own copy.
+  */
+  virtual std::shared_ptr<Product> clone() const = 0;
+
   /** Returns the fixing (observation) times */
   Vector const& fixTimes() const;
 
@@ -42,12 +48,43 @@ public:
   */
   virtual void eval(Matrix const& pricePath) = 0;
 
+  /** Evaluates the product given the passed-in single precision path.
+      The default implementation converts the path to double; products
+      override it to evaluate the float path directly.
+  */
+  virtual void eval(FMatrix const& pricePath);
+
+  /** Returns true if the payments can be decided before the last fixing, e.g. on a knock-out.
+      The pricers then evaluate such products fixing by fixing with evalFixing(),
+      and stop generating a path as soon as it is decided.
+  */
+  virtual bool decidesEarly() const { return false; }
+
+  /** Starts the fixing by fixing evaluation of a new path */
+  virtual void beginPath() {}
+
+  /** Evaluates the product at fixing time index idx, given rows 0 to idx of the price path.
+      Returns true if the path is decided, i.e. the payment amounts are final and
+      the later fixings are not needed. The default implementation calls eval()
+      at the last fixing.
+  */
+  virtual bool evalFixing(size_t idx, Matrix const& pricePath);
+
   /** Evaluates the product at fixing time index idx, for a vector of current spots,
       and a given continuation value.
       Useful for PDE pricing of products with early exercise features.
   */
   virtual void eval(size_t idx, Vector const& spots, double contValue) = 0;
 
+  /** Evaluates the product at fixing time index idx on a whole slice of PDE grid nodes.
+      Each row of spots holds the spots of the assets at one node; values holds the continuation
+      values at the nodes on input, and the values after the fixing on output.
+      Unlike eval(idx, spots, contValue) it leaves the payment amounts alone, so that it is const
+      and its loop over the nodes vectorizes. The default implementation calls that eval() node by node,
+      on a copy of the product.
+  */
+  virtual void evalSlice(size_t idx, Matrix const& spots, double* values) const;
+
   /** Sets up the time steps, to be used in a numerical method.
   The timesteps are returned in the std::vector<double> timesteps,
   and for each timestep, the corresponding index in the fixingTimes() array
@@ -59,11 +96,63 @@ public:
                          std::vector<double>& timesteps,
                          std::vector<ptrdiff_t>& stepindex) const;
 
+  /** Passes the variances of the log-spots over each fixing interval, as used by a pricer.
+      The matrix has one row per fixing time and one column per asset.
+      Products that account for the path between fixings (e.g. barrier crossings) override it.
+  */
+  virtual void setStepVariances(Matrix const&) {}
+
   virtual bool needsAlignment() { return false; };
 
   virtual std::vector<double> getAlignmentVector() { return {0}; };
 
+  /** Returns the spot levels where the payoff is not smooth, e.g. strikes and barriers.
+      Numerical methods may concentrate their nodes around them.
+  */
+  virtual std::vector<double> getCriticalPoints() const { return {}; }
+
+  /** Returns the spot levels at and beyond which the product is knocked out at all times and worth
+      nothing, 0 and HUGE_VAL if none. PDE solvers may end their grid there, with zero values at the edge.
+  */
+  virtual void getKnockOutLevels(double& lower, double& upper) const
+  {
+    lower = 0.0;
+    upper = HUGE_VAL;
+  }
+
+  /** Returns true if the product can be exercised at any time up to its last fixing.
+      Its value is then bounded below by exerciseValue(), an obstacle that PDE solvers
+      can enforce at every time step instead of evaluating each exercise fixing.
+  */
+  virtual bool hasEarlyExercise() const { return false; }
+
+  /** Returns the amount received on early exercise at the passed-in spots */
+  virtual double exerciseValue(Vector const&) const { return 0.0; }
+
+  /** Returns -1 if early exercise is optimal below a single critical spot, as for a put,
+      1 if above, as for a call, and 0 if the exercise region may have several parts.
+  */
+  virtual int exerciseSide() const { return 0; }
+
+  /** Same as timeSteps(), with only the product events that are still needed
+      when the early exercise is enforced at every time step.
+  */
+  virtual void timeStepsWithoutExercise(size_t nsteps,
+                                        std::vector<double>& timesteps,
+                                        std::vector<ptrdiff_t>& stepindex) const
+  {
+    timeSteps(nsteps, timesteps, stepindex);
+  }
+
 protected:
+  /** Sets up the time steps between the passed-in event times, which start at t = 0,
+      with their fixing indices, -1 for no fixing */
+  static void fillTimeSteps(std::vector<double> const& eventtimes,
+                            std::vector<ptrdiff_t> const& eventindex,
+                            size_t nsteps,
+                            std::vector<double>& timesteps,
+                            std::vector<ptrdiff_t>& stepindex);
+
   std::string payccy_;
   Vector fixTimes_;       // the fixing (observation) times
   Vector payTimes_;       // the payment times
@@ -81,6 +170,34 @@ Product::Product(std::string const& payccy)
 : payccy_(payccy)
 {}
 
+inline
+void Product::eval(FMatrix const& pricePath)
+{
+  eval(arma::conv_to<Matrix>::from(pricePath));
+}
+
+inline
+void Product::evalSlice(size_t idx, Matrix const& spots, double* values) const
+{
+  std::shared_ptr<Product> prod = clone();
+  Vector nodeSpots(spots.n_cols);
+  for (size_t i = 0; i < spots.n_rows; ++i) {
+    for (size_t k = 0; k < spots.n_cols; ++k)
+      nodeSpots[k] = spots(i, k);
+    prod->eval(idx, nodeSpots, values[i]);
+    values[i] = prod->payAmounts()[idx];
+  }
+}
+
+inline
+bool Product::evalFixing(size_t idx, Matrix const& pricePath)
+{
+  if (idx + 1 < fixTimes_.size())
+    return false;
+  eval(pricePath);
+  return true;
+}
+
 inline
 Vector const& Product::fixTimes() const
 {
@@ -104,9 +221,6 @@ void Product::timeSteps(size_t nsteps,
                         std::vector<double>& timesteps,
                         std::vector<ptrdiff_t>& stepindex) const
 {
-  timesteps.clear();
-  stepindex.clear();
-
   // first put all the fixing times into a temp array, starting with t = 0
   std::vector<double> tstemp(1, 0.0);
   // put the indices also in a temp array
@@ -123,26 +237,39 @@ void Product::timeSteps(size_t nsteps,
 
   // NOTE: here we can put other time steps such as ex-div dates for discrete divs.
 
+  fillTimeSteps(tstemp, idxtemp, nsteps, timesteps, stepindex);
+}
+
+inline
+void Product::fillTimeSteps(std::vector<double> const& eventtimes,
+                            std::vector<ptrdiff_t> const& eventindex,
+                            size_t nsteps,
+                            std::vector<double>& timesteps,
+                            std::vector<ptrdiff_t>& stepindex)
+{
+  timesteps.clear();
+  stepindex.clear();
+
   // compute the timestep size
-  double maxTime = tstemp[tstemp.size() - 1];
+  double maxTime = eventtimes[eventtimes.size() - 1];
   double maxdt = maxTime / std::max(nsteps, size_t(1));
 
-  for (size_t i = 0; i < tstemp.size() - 1; ++i) {
-    timesteps.push_back(tstemp[i]);           // add the time step
-    stepindex.push_back(idxtemp[i]);          // add the index
-    double dt = tstemp[i + 1] - tstemp[i];
+  for (size_t i = 0; i < eventtimes.size() - 1; ++i) {
+    timesteps.push_back(eventtimes[i]);       // add the time step
+    stepindex.push_back(eventindex[i]);      // add the index
+    double dt = eventtimes[i + 1] - eventtimes[i];
     if (dt - maxdt > 1.0e-8) {                // insert more steps in between
       size_t n = size_t(dt / maxdt);
       dt /= n;
-      double T1 = tstemp[i];
+      double T1 = eventtimes[i];
       for (size_t j = 1; j < n; ++j) {
         timesteps.push_back(T1 + j * dt);
         stepindex.push_back(-1);  // this is not a product event
       }
     }
   }
-  timesteps.push_back(tstemp.back());
-  stepindex.push_back(idxtemp.back());
+  timesteps.push_back(eventtimes.back());
+  stepindex.push_back(eventindex.back());
 }
 
 END_NAMESPACE(orf)
@@ -6,7 +6,10 @@
 #include <orflib/market/market.hpp>
 #include <orflib/products/europeancallput.hpp>
 #include <orflib/products/americancallput.hpp>
+#include <orflib/products/asianbasketcallput.hpp>
 #include <orflib/methods/pde/pde1dsolver.hpp>
+#include <orflib/methods/pde/pde2dsolver.hpp>
+#include <orflib/methods/pde/pde1dforwardsolver.hpp>
 
 #include <xlorflib/xlutils.hpp>
 #include <xlw/xlw.h>
@@ -35,7 +38,8 @@ LPXLFOPER EXCEL_EXPORT xlOrfEuroBSPDE(LPXLFOPER xlPayoffType,
 
   int payoffType = XlfOper(xlPayoffType).AsInt();
   double spot = XlfOper(xlSpot).AsDouble();
-  double strike = XlfOper(xlStrike).AsDouble();
+  // one strike or a range of strikes, priced together on the same grid
+  Vector strikes = xlOperToVector(XlfOper(xlStrike));
   double timeToExp = XlfOper(xlTimeToExp).AsDouble();
 
   std::string name = xlStripTick(XlfOper(xlDiscountCrv).AsString());
@@ -63,20 +67,23 @@ LPXLFOPER EXCEL_EXPORT xlOrfEuroBSPDE(LPXLFOPER xlPayoffType,
   else
     headers = XlfOper(xlHeaders).AsBool();
 
-  // create the product
-  SPtrProduct spprod(new EuropeanCallPut(payoffType, strike, timeToExp));
-  // create the PDE solver
+  // create the products, one per strike
+  std::vector<SPtrProduct> products;
+  for (size_t i = 0; i < strikes.size(); ++i)
+    products.push_back(SPtrProduct(new EuropeanCallPut(payoffType, strikes[i], timeToExp)));
+  // create the PDE solver, one layer per strike
   Pde1DResults results;
-  Pde1DSolver solver(spprod, spyc, spot, divYield, spvol, results);
+  Pde1DSolver solver(products, spyc, spot, divYield, spvol, results);
   solver.solve(pdeparams);
 
   // write results to the outbound XlfOper
   RW offset = headers ? 1 : 0;
-  XlfOper xlRet(1 + offset, 1); // construct a range of size 2 x 1
+  XlfOper xlRet(offset + (RW)strikes.size(), 1); // one row per strike, plus the header
   if (headers) {
     xlRet(0, 0) = "Price";
   }
-  xlRet(offset, 0) = results.prices[0];
+  for (size_t i = 0; i < strikes.size(); ++i)
+    xlRet(offset + (RW)i, 0) = results.prices[i];
 
   return xlRet;
 
@@ -138,8 +145,12 @@ LPXLFOPER EXCEL_EXPORT xlOrfAmerBSPDE(LPXLFOPER xlPayoffType,
   solver.solve(pdeparams);
 
   // write results to the outbound XlfOper
-  RW nrows = headers ? 1 + (RW)results.times.size() : 1;
-  COL ncols = headers ? 2 + (COL)results.values.front().n_rows : 1;
+  Vector times, spots;
+  std::vector<PdeSliceView> values;
+  if (headers)
+    results.getValues(0, times, spots, values);
+  RW nrows = headers ? 1 + (RW)times.size() : 1;
+  COL ncols = headers ? 2 + (COL)spots.size() : 1;
   XlfOper xlRet(nrows, ncols); // construct a range of size nrows x ncols
   if (headers) {
     xlRet(0, 0) = "Price";
@@ -147,15 +158,12 @@ LPXLFOPER EXCEL_EXPORT xlOrfAmerBSPDE(LPXLFOPER xlPayoffType,
     for (RW i = 2; i < nrows; ++i)  xlRet(i, 0) = XlfOper::Error(xlerrNA);
 
     xlRet(0, 1) = "Time/Spot";
-    Vector spots;
-    results.getSpotAxis(0, spots);
-
     for (size_t i = 0; i < spots.size(); ++i)
       xlRet(0, 2 + (COL)i) = spots[i];
-    for (size_t i = 0; i < results.times.size(); ++i) {
-      xlRet(1 + (RW)i, 1) = results.times[i];
-      for (size_t j = 0; j < results.values.front().n_rows; ++j)
-        xlRet(1 + (RW)i, 2 + (COL)j) = results.values[i](j, 0);
+    for (size_t i = 0; i < times.size(); ++i) {
+      xlRet(1 + (RW)i, 1) = times[i];
+      for (size_t j = 0; j < spots.size(); ++j)
+        xlRet(1 + (RW)i, 2 + (COL)j) = values[i](j);
     }
   }
   else {
@@ -167,4 +175,143 @@ LPXLFOPER EXCEL_EXPORT xlOrfAmerBSPDE(LPXLFOPER xlPayoffType,
   EXCEL_END;
 }
 
+LPXLFOPER EXCEL_EXPORT xlOrfBasketBSPDE(LPXLFOPER xlPayoffType,
+                                        LPXLFOPER xlStrike,
+                                        LPXLFOPER xlTimeToExp,
+                                        LPXLFOPER xlAssetQuantities,
+                                        LPXLFOPER xlSpots,
+                                        LPXLFOPER xlDiscountCrv,
+                                        LPXLFOPER xlDivYields,
+                                        LPXLFOPER xlVolatilities,
+                                        LPXLFOPER xlCorrelation,
+                                        LPXLFOPER xlPdeParams,
+                                        LPXLFOPER xlHeaders)
+{
+  EXCEL_BEGIN;
+
+  if (XlfExcel::Instance().IsCalledByFuncWiz())
+    return XlfOper(true);
+
+  int payoffType = XlfOper(xlPayoffType).AsInt();
+  double strike = XlfOper(xlStrike).AsDouble();
+  double timeToExp = XlfOper(xlTimeToExp).AsDouble();
+  Vector assetQuantities = xlOperToVector(XlfOper(xlAssetQuantities));
+  Vector spots = xlOperToVector(XlfOper(xlSpots));
+
+  std::string name = xlStripTick(XlfOper(xlDiscountCrv).AsString());
+  SPtrYieldCurve spyc = market().yieldCurves().get(name);
+  ORF_ASSERT(spyc, "error: yield curve " + name + " not found");
+
+  Vector divYields = xlOperToVector(XlfOper(xlDivYields));
+  Vector volatilities = xlOperToVector(XlfOper(xlVolatilities));
+  ORF_ASSERT(volatilities.size() == 2, "error: the basket must have two assets");
+  std::vector<SPtrVolatilityTermStructure> spvols;
+  for (size_t i = 0; i < volatilities.size(); ++i) {
+    double vol = volatilities[i];
+    spvols.push_back(SPtrVolatilityTermStructure(
+      new VolatilityTermStructure(&timeToExp, &timeToExp + 1, &vol, &vol + 1)));
+  }
+  double correlation = XlfOper(xlCorrelation).AsDouble();
+
+  // read the PDE parameters, for both assets
+  PdeParams pdeparams = xlOperToPdeParams(XlfOper(xlPdeParams), 2);
+  // handling the xlHeaders argument
+  bool headers;
+  if (XlfOper(xlHeaders).IsMissing() || XlfOper(xlHeaders).IsNil())
+    headers = false;
+  else
+    headers = XlfOper(xlHeaders).AsBool();
+
+  // create the product, a basket option with a single fixing at expiration
+  Vector fixingTimes(1);
+  fixingTimes[0] = timeToExp;
+  SPtrProduct spprod(new AsianBasketCallPut(payoffType, strike, fixingTimes, assetQuantities));
+  // create the PDE solver
+  Pde2DResults results;
+  Pde2DSolver solver(spprod, spyc, spots, divYields, spvols, correlation, results);
+  solver.solve(pdeparams);
+
+  // write results to the outbound XlfOper
+  RW offset = headers ? 1 : 0;
+  XlfOper xlRet(1 + offset, 1); // construct a range of size 1 x 1, plus the header
+  if (headers) {
+    xlRet(0, 0) = "Price";
+  }
+  xlRet(offset, 0) = results.prices[0];
+
+  return xlRet;
+
+  EXCEL_END;
+}
+
+LPXLFOPER EXCEL_EXPORT xlOrfEuroSurfBSPDE(LPXLFOPER xlStrikes,
+                                          LPXLFOPER xlMaturities,
+                                          LPXLFOPER xlSpot,
+                                          LPXLFOPER xlDiscountCrv,
+                                          LPXLFOPER xlDivYield,
+                                          LPXLFOPER xlVolatility,
+                                          LPXLFOPER xlPdeParams,
+                                          LPXLFOPER xlHeaders)
+{
+  EXCEL_BEGIN;
+
+  if (XlfExcel::Instance().IsCalledByFuncWiz())
+    return XlfOper(true);
+
+  Vector strikes = xlOperToVector(XlfOper(xlStrikes));
+  Vector maturities = xlOperToVector(XlfOper(xlMaturities));
+  ORF_ASSERT(maturities.size() > 0, "error: no maturities");
+  double spot = XlfOper(xlSpot).AsDouble();
+
+  std::string name = xlStripTick(XlfOper(xlDiscountCrv).AsString());
+  SPtrYieldCurve spyc = market().yieldCurves().get(name);
+  ORF_ASSERT(spyc, "error: yield curve " + name + " not found");
+
+  double divYield = XlfOper(xlDivYield).AsDouble();
+  SPtrVolatilityTermStructure spvol;
+  if (XlfOper(xlVolatility).IsNumber()) {
+    double vol = XlfOper(xlVolatility).AsDouble();
+    double T = maturities[maturities.size() - 1];
+    spvol.reset(new VolatilityTermStructure(&T, &T + 1, &vol, &vol + 1));
+  }
+  else {  // assume string
+    std::string volname = xlStripTick(XlfOper(xlVolatility).AsString());
+    spvol = market().volatilities().get(volname);
+    ORF_ASSERT(spvol, "error: volatility " + volname + " not found");
+  }
+
+  // read the PDE parameters
+  PdeParams pdeparams = xlOperToPdeParams(xlPdeParams);
+  // handling the xlHeaders argument
+  bool headers;
+  if (XlfOper(xlHeaders).IsMissing() || XlfOper(xlHeaders).IsNil())
+    headers = false;
+  else
+    headers = XlfOper(xlHeaders).AsBool();
+
+  // all the calls in one forward solve
+  Pde1DForwardResults results;
+  Pde1DForwardSolver solver(spot, spyc, divYield, spvol, results);
+  solver.solve(pdeparams, maturities, strikes);
+
+  // write results to the outbound XlfOper, one row per maturity and one column per strike,
+  // headed by the strikes and the maturities
+  RW offset = headers ? 1 : 0;
+  XlfOper xlRet(offset + (RW)maturities.size(), offset + (COL)strikes.size());
+  if (headers) {
+    xlRet(0, 0) = "Maturity";
+    for (size_t k = 0; k < strikes.size(); ++k)
+      xlRet(0, offset + (COL)k) = strikes[k];
+    for (size_t m = 0; m < maturities.size(); ++m)
+      xlRet(offset + (RW)m, 0) = maturities[m];
+  }
+  for (size_t m = 0; m < maturities.size(); ++m)
+    for (size_t k = 0; k < strikes.size(); ++k)
+      xlRet(offset + (RW)m, offset + (COL)k) = results.callPrices(m, k);
+
+  return xlRet;
+
+  EXCEL_END;
+}
+
 END_EXTERN_C
@@ -7,13 +7,38 @@
 #include <orflib/pricers/simplepricers.hpp>
 #include <orflib/methods/pde/pde1dsolver.hpp>
 #include <orflib/products/barriercallput.hpp>
+#include <orflib/pricers/bsmcpricer.hpp>
+#include <orflib/math/stats/meanvarcalculator.hpp>
 
 #include <xlorflib/xlutils.hpp>
 #include <xlw/xlw.h>
 
+#include <cmath>
+
 using namespace xlw;
 using namespace orf;
 
+namespace {
+
+  // converts the Excel frequency code to the barrier monitoring frequency
+  BarrierCallPut::Freq xlToBarrierFreq(int frequency)
+  {
+    switch (frequency) {
+    case 0:
+      return BarrierCallPut::Freq::MONTHLY;
+    case 1:
+      return BarrierCallPut::Freq::WEEKLY;
+    case 2:
+      return BarrierCallPut::Freq::DAILY;
+    case 3:
+      return BarrierCallPut::Freq::CONTINUOUS;
+    default:
+      ORF_ASSERT(0, "error: unknown barrier option frequency type");
+    }
+    return BarrierCallPut::Freq::DAILY;
+  }
+}
+
 BEGIN_EXTERN_C
 
 LPXLFOPER EXCEL_EXPORT xlOrfBarrBS(LPXLFOPER xlPayoffType,
@@ -78,20 +103,7 @@ LPXLFOPER EXCEL_EXPORT xlOrfBarrBSPDE(LPXLFOPER xlPayoffType,
   double timeToExp = XlfOper(xlTimeToExp).AsDouble();
   int frequency = XlfOper(xlFrequency).AsInt();
 
-  BarrierCallPut::Freq freq;
-  switch (frequency) {
-  case 0:
-    freq = BarrierCallPut::Freq::MONTHLY;
-    break;
-  case 1:
-    freq = BarrierCallPut::Freq::WEEKLY;
-    break;
-  case 2:
-    freq = BarrierCallPut::Freq::DAILY;
-    break;
-  default:
-    ORF_ASSERT(0, "error: unknown barrier option frequency type");
-  }
+  BarrierCallPut::Freq freq = xlToBarrierFreq(frequency);
 
   std::string barrier_type = xlStripTick(XlfOper(xlBarrierType).AsString());
   // make the barrier type argument case insensitive.
@@ -133,8 +145,12 @@ LPXLFOPER EXCEL_EXPORT xlOrfBarrBSPDE(LPXLFOPER xlPayoffType,
   Pde1DSolver solver(spprod, spyc, spot, divYield, spvol, results, storeAllResults);
   solver.solve(pdeparams);
 
-  RW nrows = headers ? 1 + (RW)results.times.size() : 1;
-  COL ncols = headers ? 2 + (COL)results.values.front().n_rows : 1;
+  Vector times, spots;
+  std::vector<PdeSliceView> values;
+  if (headers)
+    results.getValues(0, times, spots, values);
+  RW nrows = headers ? 1 + (RW)times.size() : 1;
+  COL ncols = headers ? 2 + (COL)spots.size() : 1;
   XlfOper xlRet(nrows, ncols); // construct a range of size nrows x ncols
   if (headers) {
     xlRet(0, 0) = "Price";
@@ -142,15 +158,12 @@ LPXLFOPER EXCEL_EXPORT xlOrfBarrBSPDE(LPXLFOPER xlPayoffType,
     for (RW i = 2; i < nrows; ++i)  xlRet(i, 0) = XlfOper::Error(xlerrNA);
 
     xlRet(0, 1) = "Time/Spot";
-    Vector spots;
-    results.getSpotAxis(0, spots);
-
     for (size_t i = 0; i < spots.size(); ++i)
       xlRet(0, 2 + (COL)i) = spots[i];
-    for (size_t i = 0; i < results.times.size(); ++i) {
-      xlRet(1 + (RW)i, 1) = results.times[i];
-      for (size_t j = 0; j < results.values.front().n_rows; ++j)
-        xlRet(1 + (RW)i, 2 + (COL)j) = results.values[i](j, 0);
+    for (size_t i = 0; i < times.size(); ++i) {
+      xlRet(1 + (RW)i, 1) = times[i];
+      for (size_t j = 0; j < spots.size(); ++j)
+        xlRet(1 + (RW)i, 2 + (COL)j) = values[i](j);
     }
   }
   else {
@@ -162,4 +175,85 @@ LPXLFOPER EXCEL_EXPORT xlOrfBarrBSPDE(LPXLFOPER xlPayoffType,
   EXCEL_END;
 }
 
+LPXLFOPER EXCEL_EXPORT xlOrfBarrBSMC(LPXLFOPER xlPayoffType,
+                                     LPXLFOPER xlStrike,
+                                     LPXLFOPER xlTimeToExp,
+                                     LPXLFOPER xlSpot,
+                                     LPXLFOPER xlBarrier,
+                                     LPXLFOPER xlBarrierType,
+                                     LPXLFOPER xlFrequency,
+                                     LPXLFOPER xlNSimDates,
+                                     LPXLFOPER xlDiscountCrv,
+                                     LPXLFOPER xlDivYield,
+                                     LPXLFOPER xlVolatility,
+                                     LPXLFOPER xlMcParams,
+                                     LPXLFOPER xlNPaths,
+                                     LPXLFOPER xlHeaders)
+{
+  EXCEL_BEGIN;
+
+  if (XlfExcel::Instance().IsCalledByFuncWiz())
+    return XlfOper(true);
+
+  int payoffType = XlfOper(xlPayoffType).AsInt();
+  double spot = XlfOper(xlSpot).AsDouble();
+  double strike = XlfOper(xlStrike).AsDouble();
+  double barrier = XlfOper(xlBarrier).AsDouble();
+  double timeToExp = XlfOper(xlTimeToExp).AsDouble();
+  BarrierCallPut::Freq freq = xlToBarrierFreq(XlfOper(xlFrequency).AsInt());
+  size_t nSimDates = 0;
+  if (!XlfOper(xlNSimDates).IsMissing() && !XlfOper(xlNSimDates).IsNil())
+    nSimDates = XlfOper(xlNSimDates).AsInt();
+
+  std::string barrierType = xlStripTick(XlfOper(xlBarrierType).AsString());
+  // make the barrier type argument case insensitive.
+  transform(barrierType.begin(), barrierType.end(), barrierType.begin(), ::tolower);
+
+  std::string name = xlStripTick(XlfOper(xlDiscountCrv).AsString());
+  SPtrYieldCurve spyc = market().yieldCurves().get(name);
+  ORF_ASSERT(spyc, "error: yield curve " + name + " not found");
+
+  double divYield = XlfOper(xlDivYield).AsDouble();
+  double vol = XlfOper(xlVolatility).AsDouble();
+  // read the MC parameters
+  McParams mcparams = xlOperToMcParams(XlfOper(xlMcParams));
+  // read the number of paths
+  unsigned long npaths = XlfOper(xlNPaths).AsInt();
+  // handling the xlHeaders argument
+  bool headers;
+  if (XlfOper(xlHeaders).IsMissing() || XlfOper(xlHeaders).IsNil())
+    headers = false;
+  else
+    headers = XlfOper(xlHeaders).AsBool();
+
+  // create the product
+  SPtrProduct spprod(new BarrierCallPut(payoffType, strike, barrier, barrierType, freq, timeToExp, nSimDates));
+  // create the pricer
+  BsMcPricer bsmcpricer(spprod, spyc, divYield, vol, spot, mcparams);
+  // create the statistics calculator
+  MeanVarCalculator<double *> sc(bsmcpricer.nVariables());
+  // run the simulation
+  bsmcpricer.simulate(sc, npaths);
+  // collect results
+  Matrix const& results = sc.results();
+  // read out results
+  size_t nsamples = sc.nSamples();
+  double mean = results(0, 0);
+  double stderror = results(1, 0);
+  stderror = std::sqrt(stderror / nsamples);
+
+  // write results to the outbound XlfOper
+  RW offset = headers ? 1 : 0;
+  XlfOper xlRet(2 + offset, 1); // construct a range of size 2 x 1
+  if (headers) {
+    xlRet(0, 0) = "Price";
+  }
+  xlRet(offset, 0) = mean;
+  xlRet(offset + 1, 0) = stderror;
+
+  return xlRet;
+
+  EXCEL_END;
+}
+
 END_EXTERN_C
@@ -11,7 +11,7 @@ namespace {
   // Register the function ORF.EUROBSPDE
   XLRegistration::Arg OrfEuroBSPDEArgs[] = {
     { "PayoffType", "1: call; -1: put", "XLF_OPER" },
-    { "Strike", "strike", "XLF_OPER" },
+    { "Strike", "strike, or a range of strikes priced on the same grid", "XLF_OPER" },
     { "TimeToExp", "time to expiration", "XLF_OPER" },
     { "Spot", "spot", "XLF_OPER" },
     { "DiscountCrv", "name of the discount curve", "XLF_OPER" },
@@ -40,4 +40,37 @@ namespace {
     "xlOrfAmerBSPDE", "ORF.AMERBSPDE", "Price of an American option in the Black-Scholes model using PDE.",
     "ORFLIB", OrfAmerBSPDEArgs, 9);
 
+  // Register the function ORF.BASKETBSPDE
+  XLRegistration::Arg OrfBasketBSPDEArgs[] = {
+    { "PayoffType", "1: call; -1: put", "XLF_OPER" },
+    { "Strike", "strike", "XLF_OPER" },
+    { "TimeToExp", "time to expiration", "XLF_OPER" },
+    { "AssetQuantities", "quantities of the two assets in the basket", "XLF_OPER" },
+    { "Spots", "spots of the two assets", "XLF_OPER" },
+    { "DiscountCrv", "name of the discount curve", "XLF_OPER" },
+    { "DivYields", "dividend yields (cont. cmpd.)", "XLF_OPER" },
+    { "Vols", "volatilities", "XLF_OPER" },
+    { "Correlation", "correlation of the two assets", "XLF_OPER" },
+    { "PdeParams", "The PDE parameters", "XLF_OPER" },
+    { "Headers", "TRUE for displaying the header", "XLF_OPER" }
+  };
+  XLRegistration::XLFunctionRegistrationHelper regOrfBasketBSPDE(
+    "xlOrfBasketBSPDE", "ORF.BASKETBSPDE", "Price of a European option on a basket of two assets in the Black-Scholes model using 2-dim PDE.",
+    "ORFLIB", OrfBasketBSPDEArgs, 11);
+
+  // Register the function ORF.EUROSURFBSPDE
+  XLRegistration::Arg OrfEuroSurfBSPDEArgs[] = {
+    { "Strikes", "range of strikes", "XLF_OPER" },
+    { "Maturities", "range of increasing maturities", "XLF_OPER" },
+    { "Spot", "spot", "XLF_OPER" },
+    { "DiscountCrv", "name of the discount curve", "XLF_OPER" },
+    { "DivYield", "dividend yield (cont. cmpd.)", "XLF_OPER" },
+    { "Vol", "volatility", "XLF_OPER" },
+    { "PdeParams", "The PDE parameters", "XLF_OPER" },
+    { "Headers", "TRUE for displaying the strikes and maturities", "XLF_OPER" }
+  };
+  XLRegistration::XLFunctionRegistrationHelper regOrfEuroSurfBSPDE(
+    "xlOrfEuroSurfBSPDE", "ORF.EUROSURFBSPDE", "Prices of European calls for all strikes and maturities in the Black-Scholes model using the forward PDE.",
+    "ORFLIB", OrfEuroSurfBSPDEArgs, 8);
+
 }  // anonymous namespace
@@ -33,7 +33,7 @@ namespace {
     { "Spot", "spot", "XLF_OPER" },
     { "Barrier", "barrier level", "XLF_OPER" },
     { "Barrier Type", "barrier type: ui, uo, di, do", "XLF_OPER" },
-    { "Frequency", "0: MONTHLY, 1: WEEKLY, 2: DAILY", "XLF_OPER" },
+    { "Frequency", "0: MONTHLY, 1: WEEKLY, 2: DAILY, 3: CONTINUOUS", "XLF_OPER" },
     { "DiscountCrv", "name of the discount curve", "XLF_OPER" },
     { "DivYield", "dividend yield (cont. cmpd.)", "XLF_OPER" },
     { "Vol", "volatility", "XLF_OPER" },
@@ -43,4 +43,25 @@ namespace {
   XLRegistration::XLFunctionRegistrationHelper regOrfBarrBSPDE(
     "xlOrfBarrBSPDE", "ORF.BARRBSPDE", "Price of a Barrier option in the Black-Scholes model using PDE.",
     "ORFLIB", OrfBarrBSPDEArgs, 12);
+
+  // Register the function ORF.BARRBSMC
+  XLRegistration::Arg OrfBarrBSMCArgs[] = {
+    { "PayoffType", "1: call; -1: put", "XLF_OPER" },
+    { "Strike", "strike", "XLF_OPER" },
+    { "TimeToExp", "time to expiration", "XLF_OPER" },
+    { "Spot", "spot", "XLF_OPER" },
+    { "Barrier", "barrier level", "XLF_OPER" },
+    { "Barrier Type", "barrier type: uo, do", "XLF_OPER" },
+    { "Frequency", "0: MONTHLY, 1: WEEKLY, 2: DAILY, 3: CONTINUOUS", "XLF_OPER" },
+    { "NSimDates", "number of simulation dates; default: the monitoring dates", "XLF_OPER" },
+    { "DiscountCrv", "name of the discount curve", "XLF_OPER" },
+    { "DivYield", "dividend yield (cont. cmpd.)", "XLF_OPER" },
+    { "Vol", "volatility", "XLF_OPER" },
+    { "McParams", "Default: UrngType=MT19937; PathGenType=EULER", "XLF_OPER" },
+    { "NPaths", "The number of Monte-Carlo paths", "XLF_OPER" },
+    { "Headers", "TRUE for displaying the header", "XLF_OPER" }
+  };
+  XLRegistration::XLFunctionRegistrationHelper regOrfBarrBSMC(
+    "xlOrfBarrBSMC", "ORF.BARRBSMC", "Price of a Barrier option in the Black-Scholes model using Monte Carlo.",
+    "ORFLIB", OrfBarrBSMCArgs, 14);
 }  // anonymous namespace
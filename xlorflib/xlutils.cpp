@@ -267,6 +267,8 @@ orf::McParams xlOperToMcParams(xlw::XlfOper xlRange)
         mcparams.urngType = McParams::UrngType::RANLUX3;
       else if (paramvalue == "RANLUX4")
         mcparams.urngType = McParams::UrngType::RANLUX4;
+      else if (paramvalue == "XOSHIRO256")
+        mcparams.urngType = McParams::UrngType::XOSHIRO256;
       else if (paramvalue == "SOBOL")
         mcparams.urngType = McParams::UrngType::SOBOL;
       else
@@ -280,9 +282,27 @@ orf::McParams xlOperToMcParams(xlw::XlfOper xlRange)
         mcparams.pathGenType = McParams::PathGenType::EULER;
       else if (paramvalue == "BROWNIANBRIDGE")
         mcparams.pathGenType = McParams::PathGenType::BROWNIANBRIDGE;
+      else if (paramvalue == "PCA")
+        mcparams.pathGenType = McParams::PathGenType::PCA;
       else
         ORF_ASSERT(0, "xlOperToMcParams: invalid value for McParam " + paramname + "!");
     }
+    else  if (paramname == "PATHPRECISION") {
+      std::string paramvalue = xlRange(i, 1).AsString();
+      paramvalue = orf::trim(paramvalue);
+      std::transform(paramvalue.begin(), paramvalue.end(), paramvalue.begin(), ::toupper);
+      if (paramvalue == "DOUBLE")
+        mcparams.pathPrecision = McParams::PathPrecision::DOUBLE;
+      else if (paramvalue == "SINGLE")
+        mcparams.pathPrecision = McParams::PathPrecision::SINGLE;
+      else
+        ORF_ASSERT(0, "xlOperToMcParams: invalid value for McParam " + paramname + "!");
+    }
+    else  if (paramname == "PCARANK") {
+      int paramvalue = xlRange(i, 1).AsInt();
+      ORF_ASSERT(paramvalue >= 0, "xlOperToMcParams: PcaRank must be non-negative!");
+      mcparams.pcaRank = paramvalue;
+    }
     else
       ORF_ASSERT(0, "xlOperToMcParams: unknown McParam " + paramname + "!");
   } // next row in the range
@@ -292,14 +312,16 @@ orf::McParams xlOperToMcParams(xlw::XlfOper xlRange)
 /** Converts an Excel range with name-value pairs to an PdeParams structure.
 In the Excel range all names must be in first column and all values in the second.
 */
-orf::PdeParams xlOperToPdeParams(xlw::XlfOper xlRange)
+orf::PdeParams xlOperToPdeParams(xlw::XlfOper xlRange, size_t nDims)
 {
   RW  nr = xlRange.rows();
   COL nc = xlRange.columns();
 
   ORF_ASSERT(nr > 0, "xlOperToPdeParams: the input range is empty!");
   ORF_ASSERT(nc == 2, "xlOperToPdeParams: the input range must have two columns!");
-  PdeParams pdeparams;
+  ORF_ASSERT(nDims == 1 || nDims == 2, "xlOperToPdeParams: only 1 or 2 dimensions are supported!");
+  PdeParams pdeparams(nDims);
+  bool nodes2 = false, stddevs2 = false, concentration2 = false;   // set for the second dimension
   // row scan
   for (RW i = 0; i < nr; ++i) {
     std::string paramname = xlRange(i, 0).AsString();
@@ -321,13 +343,137 @@ orf::PdeParams xlOperToPdeParams(xlw::XlfOper xlRange)
       ORF_ASSERT(paramvalue > 0, "xlOperToPdeParams: the number of standard deviations must be positive!");
       pdeparams.nStdDevs[0] = paramvalue;
     }
+    else if (paramname == "NODECONCENTRATION" || paramname == "NODECONCENTRATION1") {
+      double paramvalue = xlRange(i, 1).AsDouble();
+      ORF_ASSERT(paramvalue >= 0.0, "xlOperToPdeParams: the node concentration must be non-negative!");
+      pdeparams.nodeConcentration[0] = paramvalue;
+    }
+    else if (paramname == "NSPOTNODES2" && nDims == 2) {
+      int paramvalue = xlRange(i, 1).AsInt();
+      ORF_ASSERT(paramvalue > 0, "xlOperToPdeParams: the number of spot nodes must be positive!");
+      pdeparams.nSpotNodes[1] = paramvalue;
+      nodes2 = true;
+    }
+    else if (paramname == "NSTDDEVS2" && nDims == 2) {
+      double paramvalue = xlRange(i, 1).AsDouble();
+      ORF_ASSERT(paramvalue > 0, "xlOperToPdeParams: the number of standard deviations must be positive!");
+      pdeparams.nStdDevs[1] = paramvalue;
+      stddevs2 = true;
+    }
+    else if (paramname == "NODECONCENTRATION2" && nDims == 2) {
+      double paramvalue = xlRange(i, 1).AsDouble();
+      ORF_ASSERT(paramvalue >= 0.0, "xlOperToPdeParams: the node concentration must be non-negative!");
+      pdeparams.nodeConcentration[1] = paramvalue;
+      concentration2 = true;
+    }
     else if (paramname == "THETA") {
       double paramvalue = xlRange(i, 1).AsDouble();
       ORF_ASSERT(paramvalue >= 0.0 && paramvalue <= 1.0, "xlOperToPdeParams: Theta must be between 0 and 1!");
       pdeparams.theta = paramvalue;
     }
+    else if (paramname == "SCHEME") {
+      std::string paramvalue = xlRange(i, 1).AsString();
+      paramvalue = orf::trim(paramvalue);
+      std::transform(paramvalue.begin(), paramvalue.end(), paramvalue.begin(), ::toupper);
+
+      if (paramvalue == "THETA")
+        pdeparams.scheme = PdeParams::Scheme::THETA;
+      else if (paramvalue == "RANNACHER")
+        pdeparams.scheme = PdeParams::Scheme::RANNACHER;
+      else if (paramvalue == "BDF2")
+        pdeparams.scheme = PdeParams::Scheme::BDF2;
+      else if (paramvalue == "TRBDF2" || paramvalue == "TR-BDF2")
+        pdeparams.scheme = PdeParams::Scheme::TRBDF2;
+      else
+        ORF_ASSERT(0, "xlOperToPdeParams: invalid value for PdeParam " + paramname + "!");
+    }
+    else if (paramname == "NSMOOTHINGSTEPS") {
+      int paramvalue = xlRange(i, 1).AsInt();
+      ORF_ASSERT(paramvalue >= 0, "xlOperToPdeParams: the number of smoothing steps must be non-negative!");
+      pdeparams.nSmoothingSteps = paramvalue;
+    }
+    else if (paramname == "TIMESTEPTOLERANCE") {
+      double paramvalue = xlRange(i, 1).AsDouble();
+      ORF_ASSERT(paramvalue >= 0.0, "xlOperToPdeParams: the time step tolerance must be non-negative!");
+      pdeparams.timeStepTolerance = paramvalue;
+    }
+    else if (paramname == "EXERCISE") {
+      std::string paramvalue = xlRange(i, 1).AsString();
+      paramvalue = orf::trim(paramvalue);
+      std::transform(paramvalue.begin(), paramvalue.end(), paramvalue.begin(), ::toupper);
+
+      if (paramvalue == "FIXINGS")
+        pdeparams.exercise = PdeParams::Exercise::FIXINGS;
+      else if (paramvalue == "BRENNANSCHWARTZ" || paramvalue == "BRENNAN-SCHWARTZ")
+        pdeparams.exercise = PdeParams::Exercise::BRENNAN_SCHWARTZ;
+      else if (paramvalue == "PSOR")
+        pdeparams.exercise = PdeParams::Exercise::PSOR;
+      else if (paramvalue == "POLICYITERATION" || paramvalue == "POLICY-ITERATION")
+        pdeparams.exercise = PdeParams::Exercise::POLICY_ITERATION;
+      else
+        ORF_ASSERT(0, "xlOperToPdeParams: invalid value for PdeParam " + paramname + "!");
+    }
+    else if (paramname == "ADISCHEME") {
+      std::string paramvalue = xlRange(i, 1).AsString();
+      paramvalue = orf::trim(paramvalue);
+      std::transform(paramvalue.begin(), paramvalue.end(), paramvalue.begin(), ::toupper);
+
+      if (paramvalue == "DOUGLAS")
+        pdeparams.adiScheme = PdeParams::AdiScheme::DOUGLAS;
+      else if (paramvalue == "CRAIGSNEYD" || paramvalue == "CRAIG-SNEYD")
+        pdeparams.adiScheme = PdeParams::AdiScheme::CRAIG_SNEYD;
+      else if (paramvalue == "HUNDSDORFERVERWER" || paramvalue == "HUNDSDORFER-VERWER")
+        pdeparams.adiScheme = PdeParams::AdiScheme::HUNDSDORFER_VERWER;
+      else
+        ORF_ASSERT(0, "xlOperToPdeParams: invalid value for PdeParam " + paramname + "!");
+    }
+    else if (paramname == "NTHREADS") {
+      int paramvalue = xlRange(i, 1).AsInt();
+      ORF_ASSERT(paramvalue >= 0, "xlOperToPdeParams: the number of threads must be non-negative!");
+      pdeparams.nThreads = paramvalue;
+    }
+    else if (paramname == "STOREEVERY") {
+      int paramvalue = xlRange(i, 1).AsInt();
+      ORF_ASSERT(paramvalue > 0, "xlOperToPdeParams: StoreEvery must be positive!");
+      pdeparams.storeEvery = paramvalue;
+    }
+    else if (paramname == "SPATIALSCHEME") {
+      std::string paramvalue = xlRange(i, 1).AsString();
+      paramvalue = orf::trim(paramvalue);
+      std::transform(paramvalue.begin(), paramvalue.end(), paramvalue.begin(), ::toupper);
+
+      if (paramvalue == "CENTRAL")
+        pdeparams.spatialScheme = PdeParams::SpatialScheme::CENTRAL;
+      else if (paramvalue == "COMPACT")
+        pdeparams.spatialScheme = PdeParams::SpatialScheme::COMPACT;
+      else
+        ORF_ASSERT(0, "xlOperToPdeParams: invalid value for PdeParam " + paramname + "!");
+    }
+    else if (paramname == "STORAGEPRECISION") {
+      std::string paramvalue = xlRange(i, 1).AsString();
+      paramvalue = orf::trim(paramvalue);
+      std::transform(paramvalue.begin(), paramvalue.end(), paramvalue.begin(), ::toupper);
+
+      if (paramvalue == "DOUBLE")
+        pdeparams.storagePrecision = PdeParams::StoragePrecision::DOUBLE;
+      else if (paramvalue == "FLOAT")
+        pdeparams.storagePrecision = PdeParams::StoragePrecision::FLOAT;
+      else
+        ORF_ASSERT(0, "xlOperToPdeParams: invalid value for PdeParam " + paramname + "!");
+    }
+    else if (paramname == "STORAGEFILE") {
+      pdeparams.storageFile = orf::trim(xlRange(i, 1).AsString());
+    }
     else
       ORF_ASSERT(0, "xlOperToPdeParams: unknown PdeParam " + paramname + "!");
   } // next row in the range
+  if (nDims == 2) {
+    if (!nodes2)
+      pdeparams.nSpotNodes[1] = pdeparams.nSpotNodes[0];
+    if (!stddevs2)
+      pdeparams.nStdDevs[1] = pdeparams.nStdDevs[0];
+    if (!concentration2)
+      pdeparams.nodeConcentration[1] = pdeparams.nodeConcentration[0];
+  }
   return pdeparams;
 }
@@ -45,7 +45,8 @@ xlw::XlfOper xlMatrixToOper(orf::Matrix const & mat);
 */
 orf::McParams xlOperToMcParams(xlw::XlfOper xlRange);
 
-/** Converts an Excel range with name-value pairs to an PdeParams structure.
+/** Converts an Excel range with name-value pairs to an PdeParams structure for nDims dimensions.
     In the Excel range all names must be in first column and all values in the second.
+    The settings of the second dimension that are missing are those of the first.
 */
-orf::PdeParams xlOperToPdeParams(xlw::XlfOper xlRange);
\ No newline at end of file
+orf::PdeParams xlOperToPdeParams(xlw::XlfOper xlRange, size_t nDims = 1);
\ No newline at end of file